@@ -0,0 +1,141 @@
+// Запекание неподвижной сцены. Фигуры один раз раскладываются на
+// треугольники (заливка и обводка, уже в координатах окна) и загружаются
+// в один VertexBuffer на видеокарте; дальше каждый кадр - один вызов draw
+// без создания фигур и пересчета их вершин. Порядок фигур сохраняется:
+// добавленная позже рисуется поверх. Работает и с SFML 2, и с SFML 3
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace sf;
+using namespace std;
+
+struct BakedScene {
+    vector<Vertex> vertices; // без поддержки VertexBuffer рисуется отсюда
+    VertexBuffer buffer{PrimitiveType::Triangles, VertexBuffer::Usage::Static};
+    bool isUploaded = false;
+};
+
+// Единичная нормаль к ребру from -> to
+inline Vector2f getEdgeNormal(
+    const Vector2f &from,
+    const Vector2f &to
+) {
+    const Vector2f normal(from.y - to.y, to.x - from.x);
+    const float length = sqrt(normal.x * normal.x + normal.y * normal.y);
+    return length > 0.f ? Vector2f(normal.x / length, normal.y / length) : normal;
+}
+
+inline void appendTriangle(
+    vector<Vertex> &vertices,
+    const Vector2f &a,
+    const Vector2f &b,
+    const Vector2f &c,
+    const Color &color
+) {
+    vertices.push_back(Vertex{a, color});
+    vertices.push_back(Vertex{b, color});
+    vertices.push_back(Vertex{c, color});
+}
+
+// Обводка как в Shape: внутренний край по точкам фигуры, внешний сдвинут
+// по биссектрисе нормалей соседних ребер, чтобы толщина была везде одинаковой
+inline void appendOutline(
+    vector<Vertex> &vertices,
+    const vector<Vector2f> &points,
+    const Vector2f &center,
+    const float thickness,
+    const Transform &transform,
+    const Color &color
+) {
+    const size_t count = points.size();
+    vector<Vector2f> outer(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Vector2f &previous = points[(i + count - 1) % count];
+        const Vector2f &point = points[i];
+        const Vector2f &next = points[(i + 1) % count];
+        Vector2f first = getEdgeNormal(previous, point);
+        Vector2f second = getEdgeNormal(point, next);
+        // нормали должны смотреть наружу, от центра фигуры
+        const Vector2f toCenter(center.x - point.x, center.y - point.y);
+        if (first.x * toCenter.x + first.y * toCenter.y > 0.f) {
+            first = Vector2f(-first.x, -first.y);
+        }
+        if (second.x * toCenter.x + second.y * toCenter.y > 0.f) {
+            second = Vector2f(-second.x, -second.y);
+        }
+        const float factor = (1.f + first.x * second.x + first.y * second.y) / thickness;
+        outer[i] = Vector2f(point.x + (first.x + second.x) / factor, point.y + (first.y + second.y) / factor);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t next = (i + 1) % count;
+        const Vector2f innerA = transform.transformPoint(points[i]);
+        const Vector2f outerA = transform.transformPoint(outer[i]);
+        const Vector2f innerB = transform.transformPoint(points[next]);
+        const Vector2f outerB = transform.transformPoint(outer[next]);
+        appendTriangle(vertices, innerA, outerA, innerB, color);
+        appendTriangle(vertices, outerA, outerB, innerB, color);
+    }
+}
+
+// Разложить выпуклую фигуру на треугольники с ее текущим преобразованием.
+// Текстуры не поддерживаются: запекается только цвет
+inline void addShape(
+    BakedScene &scene,
+    const Shape &shape
+) {
+    const size_t count = shape.getPointCount();
+    if (count < 3) {
+        return;
+    }
+    vector<Vector2f> points(count);
+    Vector2f center;
+    for (size_t i = 0; i < count; ++i) {
+        points[i] = shape.getPoint(i);
+        center.x += points[i].x / static_cast<float>(count);
+        center.y += points[i].y / static_cast<float>(count);
+    }
+
+    const Transform &transform = shape.getTransform();
+    const Vector2f worldCenter = transform.transformPoint(center);
+    // веер из центра, как в Shape
+    for (size_t i = 0; i < count; ++i) {
+        appendTriangle(
+            scene.vertices,
+            worldCenter,
+            transform.transformPoint(points[i]),
+            transform.transformPoint(points[(i + 1) % count]),
+            shape.getFillColor()
+        );
+    }
+    if (shape.getOutlineThickness() != 0.f) {
+        appendOutline(scene.vertices, points, center, shape.getOutlineThickness(), transform, shape.getOutlineColor());
+    }
+    scene.isUploaded = false;
+}
+
+// Загрузить вершины в видеопамять; вызывается после последнего addShape.
+// false - VertexBuffer недоступен, сцена рисуется из памяти процесса
+inline bool bakeScene(
+    BakedScene &scene
+) {
+    scene.isUploaded = VertexBuffer::isAvailable() &&
+                       scene.buffer.create(scene.vertices.size()) &&
+                       scene.buffer.update(scene.vertices.data());
+    return scene.isUploaded;
+}
+
+inline void drawScene(
+    RenderTarget &target,
+    const BakedScene &scene
+) {
+    if (scene.isUploaded) {
+        target.draw(scene.buffer);
+    } else {
+        target.draw(scene.vertices.data(), scene.vertices.size(), PrimitiveType::Triangles);
+    }
+}
@@ -0,0 +1,84 @@
+// Разбор опций командной строки вида "--name value" и флагов "--name".
+// При ошибке или без опции - значение по умолчанию
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+inline bool hasFlag(
+    const vector<string> &args,
+    const string &flag
+) {
+    return find(args.begin(), args.end(), flag) != args.end();
+}
+
+// Значение опции вида "--threads 8"; ноль считается ошибкой
+inline size_t getCountOption(
+    const vector<string> &args,
+    const string &name,
+    const size_t defaultValue
+) {
+    const auto it = find(args.begin(), args.end(), name);
+    if (it == args.end() || next(it) == args.end()) {
+        return defaultValue;
+    }
+    char *end = nullptr;
+    const unsigned long long value = strtoull(next(it)->c_str(), &end, 10);
+    return *end == '\0' && value > 0 ? static_cast<size_t>(value) : defaultValue;
+}
+
+// Значение опции вида "--seed 0", ноль допустим. Без опции value не
+// меняется; false - опция есть, но значение не целое без знака
+inline bool getUnsignedOption(
+    const vector<string> &args,
+    const string &name,
+    uint64_t &value
+) {
+    const auto it = find(args.begin(), args.end(), name);
+    if (it == args.end()) {
+        return true;
+    }
+    if (next(it) == args.end() || !isdigit(static_cast<unsigned char>((*next(it))[0]))) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    const unsigned long long parsed = strtoull(next(it)->c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Значение опции вида "--bake 60"
+inline float getFloatOption(
+    const vector<string> &args,
+    const string &name,
+    const float defaultValue
+) {
+    const auto it = find(args.begin(), args.end(), name);
+    if (it == args.end() || next(it) == args.end()) {
+        return defaultValue;
+    }
+    char *end = nullptr;
+    const float value = strtof(next(it)->c_str(), &end);
+    return *end == '\0' ? value : defaultValue;
+}
+
+// Значение опции вида "--format json"
+inline string getStringOption(
+    const vector<string> &args,
+    const string &name,
+    const string &defaultValue
+) {
+    const auto it = find(args.begin(), args.end(), name);
+    return it == args.end() || next(it) == args.end() ? defaultValue : *next(it);
+}
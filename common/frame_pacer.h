@@ -0,0 +1,117 @@
+// Ограничение частоты кадров без занятого процессора: до конца кадра спим,
+// а последний отрезок, меньше точности sleep, докручиваем в цикле.
+// Запас на докрутку подстраивается под то, насколько система просыпает
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_line.h"
+
+using namespace std;
+
+constexpr double DEFAULT_FRAME_RATE = 60.0;
+// ошибка больше этого считается заметным дрожанием кадра
+constexpr chrono::microseconds PACING_TOLERANCE{500};
+constexpr chrono::microseconds MIN_SPIN_MARGIN{200};
+constexpr chrono::microseconds MAX_SPIN_MARGIN{4000};
+
+struct FramePacer {
+    using Clock = chrono::steady_clock;
+
+    Clock::duration period = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / DEFAULT_FRAME_RATE));
+    Clock::time_point deadline = Clock::now() + period;
+    // сколько до дедлайна не спать, а крутиться; растет, если sleep просыпает
+    Clock::duration spinMargin = chrono::microseconds(1000);
+    double oversleepUs = 0; // скользящее среднее
+
+    // статистика: ошибка - насколько позже дедлайна вернулся waitNextFrame
+    uint64_t frames = 0;
+    uint64_t lateFrames = 0; // кадр сам не уложился в период
+    uint64_t jitteryFrames = 0; // ошибка больше PACING_TOLERANCE
+    double errorSumUs = 0;
+    double errorMaxUs = 0;
+};
+
+inline void setFrameRate(
+    FramePacer &pacer,
+    const double frameRate
+) {
+    pacer.period = chrono::duration_cast<FramePacer::Clock::duration>(chrono::duration<double>(1.0 / frameRate));
+    pacer.deadline = FramePacer::Clock::now() + pacer.period;
+}
+
+// Частота из опции "--fps N", по умолчанию DEFAULT_FRAME_RATE
+inline void initFramePacer(
+    FramePacer &pacer,
+    const vector<string> &args
+) {
+    const size_t frameRate = getCountOption(args, "--fps", static_cast<size_t>(DEFAULT_FRAME_RATE));
+    setFrameRate(pacer, static_cast<double>(frameRate));
+}
+
+// Начать отсчет кадров заново, например после простоя в ожидании события:
+// иначе первый кадр после простоя засчитается опоздавшим
+inline void resyncFramePacer(
+    FramePacer &pacer
+) {
+    pacer.deadline = FramePacer::Clock::now() + pacer.period;
+}
+
+// Вызывается раз в кадр, после display(): ждет начала следующего кадра
+inline void waitNextFrame(
+    FramePacer &pacer
+) {
+    using Clock = FramePacer::Clock;
+    ++pacer.frames;
+
+    Clock::time_point now = Clock::now();
+    if (now > pacer.deadline) {
+        // не догоняем пропущенное: следующий кадр отсчитывается от сейчас
+        ++pacer.lateFrames;
+        pacer.deadline = now + pacer.period;
+        return;
+    }
+
+    const Clock::time_point wakeTarget = pacer.deadline - pacer.spinMargin;
+    if (now < wakeTarget) {
+        this_thread::sleep_until(wakeTarget);
+        const double oversleep = chrono::duration<double, micro>(Clock::now() - wakeTarget).count();
+        pacer.oversleepUs += (oversleep - pacer.oversleepUs) / 8.0;
+        const auto margin = chrono::microseconds(static_cast<int64_t>(pacer.oversleepUs * 2.0));
+        pacer.spinMargin = clamp<Clock::duration>(margin, MIN_SPIN_MARGIN, MAX_SPIN_MARGIN);
+    }
+    while ((now = Clock::now()) < pacer.deadline) {
+        this_thread::yield();
+    }
+
+    const double error = chrono::duration<double, micro>(now - pacer.deadline).count();
+    pacer.errorSumUs += error;
+    pacer.errorMaxUs = max(pacer.errorMaxUs, error);
+    if (error > chrono::duration<double, micro>(PACING_TOLERANCE).count()) {
+        ++pacer.jitteryFrames;
+    }
+    pacer.deadline += pacer.period;
+}
+
+inline void printPacingReport(
+    const FramePacer &pacer
+) {
+    const uint64_t pacedFrames = pacer.frames - pacer.lateFrames;
+    if (pacer.frames == 0) {
+        return;
+    }
+    cout << "pacing: " << 1.0 / chrono::duration<double>(pacer.period).count() << " Hz, "
+            << pacer.frames << " frames, late " << pacer.lateFrames;
+    if (pacedFrames > 0) {
+        cout << ", error avg " << pacer.errorSumUs / static_cast<double>(pacedFrames)
+                << " us, max " << pacer.errorMaxUs
+                << " us, over " << PACING_TOLERANCE.count() << " us: " << pacer.jitteryFrames;
+    }
+    cout << endl;
+}
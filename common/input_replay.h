@@ -0,0 +1,296 @@
+// Запись ввода и повтор без человека: поток событий окна по кадрам вместе
+// с длительностью каждого кадра пишется в двоичный файл, а при повторе
+// программа получает те же события и те же dt. Так замеры времени кадра
+// можно сравнивать между сборками на одинаковом вводе.
+//   --record file       играть вручную и записывать
+//   --replay file       повторить в темпе записи
+//   --replay-fast file  повторить так быстро, как получится
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace sf;
+using namespace std;
+
+// "SFIR" и версия формата; числа пишутся в порядке байт машины
+constexpr uint32_t INPUT_RECORD_MAGIC = 0x52494653;
+constexpr uint32_t INPUT_RECORD_VERSION = 1;
+
+enum class InputMode {
+    Live,
+    Record,
+    Replay, // в темпе записи
+    ReplayFast // без ожидания между кадрами
+};
+
+// Записываются только события, на которые реагируют программы
+enum class RecordedEventType : uint8_t {
+    Closed,
+    MouseMoved,
+    MouseButtonPressed,
+    MouseButtonReleased
+};
+
+struct RecordedEvent {
+    RecordedEventType type = RecordedEventType::Closed;
+    uint8_t button = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+};
+
+// Кадр в файле: uint16 число событий, события, float dt кадра
+struct RecordedFrame {
+    vector<RecordedEvent> events;
+    float frameTime = 0;
+};
+
+struct InputSession {
+    InputMode mode = InputMode::Live;
+    string path;
+    ofstream output;
+    RecordedFrame frame; // запись: события текущего кадра
+    vector<RecordedFrame> frames; // повтор: весь файл
+    size_t frameIndex = 0;
+    size_t eventIndex = 0;
+    // время кадров при повторе, для отчета
+    Clock frameClock;
+    Clock replayClock;
+    float totalWorkTime = 0;
+    float maxWorkTime = 0;
+};
+
+template <typename T>
+void writeValue(
+    ostream &output,
+    const T &value
+) {
+    output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(
+    istream &input,
+    T &value
+) {
+    return static_cast<bool>(input.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+inline optional<RecordedEvent> toRecordedEvent(
+    const Event &event
+) {
+    if (event.is<Event::Closed>()) {
+        return RecordedEvent{RecordedEventType::Closed};
+    }
+    if (const auto *moved = event.getIf<Event::MouseMoved>()) {
+        return RecordedEvent{RecordedEventType::MouseMoved, 0, moved->position.x, moved->position.y};
+    }
+    if (const auto *pressed = event.getIf<Event::MouseButtonPressed>()) {
+        return RecordedEvent{
+            RecordedEventType::MouseButtonPressed,
+            static_cast<uint8_t>(pressed->button),
+            pressed->position.x,
+            pressed->position.y
+        };
+    }
+    if (const auto *released = event.getIf<Event::MouseButtonReleased>()) {
+        return RecordedEvent{
+            RecordedEventType::MouseButtonReleased,
+            static_cast<uint8_t>(released->button),
+            released->position.x,
+            released->position.y
+        };
+    }
+    return nullopt;
+}
+
+inline Event toEvent(
+    const RecordedEvent &recorded
+) {
+    const Vector2i position = {recorded.x, recorded.y};
+    const auto button = static_cast<Mouse::Button>(recorded.button);
+    switch (recorded.type) {
+        case RecordedEventType::MouseMoved:
+            return Event::MouseMoved{position};
+        case RecordedEventType::MouseButtonPressed:
+            return Event::MouseButtonPressed{button, position};
+        case RecordedEventType::MouseButtonReleased:
+            return Event::MouseButtonReleased{button, position};
+        default:
+            return Event::Closed{};
+    }
+}
+
+inline void writeFrame(
+    ostream &output,
+    const RecordedFrame &frame
+) {
+    writeValue(output, static_cast<uint16_t>(frame.events.size()));
+    for (const RecordedEvent &event: frame.events) {
+        writeValue(output, event.type);
+        writeValue(output, event.button);
+        writeValue(output, event.x);
+        writeValue(output, event.y);
+    }
+    writeValue(output, frame.frameTime);
+}
+
+inline bool readFrame(
+    istream &input,
+    RecordedFrame &frame
+) {
+    uint16_t eventsCount = 0;
+    if (!readValue(input, eventsCount)) {
+        return false;
+    }
+    frame.events.resize(eventsCount);
+    for (RecordedEvent &event: frame.events) {
+        if (!readValue(input, event.type) || !readValue(input, event.button) ||
+            !readValue(input, event.x) || !readValue(input, event.y)) {
+            return false;
+        }
+    }
+    return readValue(input, frame.frameTime);
+}
+
+inline bool loadRecording(
+    InputSession &session
+) {
+    ifstream input(session.path, ios::binary);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!readValue(input, magic) || !readValue(input, version) ||
+        magic != INPUT_RECORD_MAGIC || version != INPUT_RECORD_VERSION) {
+        return false;
+    }
+    RecordedFrame frame;
+    while (readFrame(input, frame)) {
+        session.frames.push_back(frame);
+    }
+    return true;
+}
+
+// Разобрать --record/--replay/--replay-fast. false - файл не открылся
+inline bool initInputSession(
+    InputSession &session,
+    const vector<string> &args
+) {
+    const vector<pair<string, InputMode>> options = {
+        {"--record", InputMode::Record},
+        {"--replay", InputMode::Replay},
+        {"--replay-fast", InputMode::ReplayFast},
+    };
+    for (const auto &[name, mode]: options) {
+        const auto it = find(args.begin(), args.end(), name);
+        if (it != args.end() && next(it) != args.end()) {
+            session.mode = mode;
+            session.path = *next(it);
+        }
+    }
+
+    if (session.mode == InputMode::Record) {
+        session.output.open(session.path, ios::binary);
+        writeValue(session.output, INPUT_RECORD_MAGIC);
+        writeValue(session.output, INPUT_RECORD_VERSION);
+    } else if (session.mode != InputMode::Live && !loadRecording(session)) {
+        cerr << "cannot read input recording: " << session.path << endl;
+        return false;
+    }
+    if (session.mode == InputMode::Record && !session.output) {
+        cerr << "cannot write input recording: " << session.path << endl;
+        return false;
+    }
+    session.frameClock.restart();
+    session.replayClock.restart();
+    return true;
+}
+
+inline bool isReplaying(
+    const InputSession &session
+) {
+    return session.mode == InputMode::Replay || session.mode == InputMode::ReplayFast;
+}
+
+// Замена window.pollEvent(). При повторе события окна кроме закрытия
+// отбрасываются, а после последнего кадра записи приходит Closed
+inline optional<Event> pollInputEvent(
+    InputSession &session,
+    RenderWindow &window
+) {
+    if (!isReplaying(session)) {
+        optional<Event> event = window.pollEvent();
+        if (event && session.mode == InputMode::Record) {
+            if (const optional<RecordedEvent> recorded = toRecordedEvent(*event)) {
+                session.frame.events.push_back(*recorded);
+            }
+        }
+        return event;
+    }
+
+    while (const optional<Event> event = window.pollEvent()) {
+        if (event->is<Event::Closed>()) {
+            return event;
+        }
+    }
+    if (session.frameIndex >= session.frames.size()) {
+        return Event::Closed{};
+    }
+    const RecordedFrame &frame = session.frames[session.frameIndex];
+    if (session.eventIndex < frame.events.size()) {
+        return toEvent(frame.events[session.eventIndex++]);
+    }
+    return nullopt;
+}
+
+// Длительность кадра вместо clock.restart(); вызывается раз в кадр после
+// pollInputEvent. При повторе возвращает записанный dt, а в темпе записи
+// еще и ждет, пока кадр не займет столько же реального времени
+inline float advanceInputFrame(
+    InputSession &session,
+    Clock &clock
+) {
+    if (!isReplaying(session)) {
+        const float frameTime = clock.restart().asSeconds();
+        if (session.mode == InputMode::Record) {
+            session.frame.frameTime = frameTime;
+            writeFrame(session.output, session.frame);
+            session.frame.events.clear();
+        }
+        return frameTime;
+    }
+
+    if (session.frameIndex >= session.frames.size()) {
+        return 0;
+    }
+    const float frameTime = session.frames[session.frameIndex].frameTime;
+    const float workTime = session.frameClock.getElapsedTime().asSeconds();
+    session.totalWorkTime += workTime;
+    session.maxWorkTime = max(session.maxWorkTime, workTime);
+    if (session.mode == InputMode::Replay && workTime < frameTime) {
+        sleep(seconds(frameTime - workTime));
+    }
+    session.frameClock.restart();
+    ++session.frameIndex;
+    session.eventIndex = 0;
+    return frameTime;
+}
+
+// Итог повтора: сколько кадров, за сколько секунд, и сколько в среднем
+// и максимум заняла работа кадра без ожидания в режиме --replay
+inline void printReplayReport(
+    const InputSession &session
+) {
+    if (!isReplaying(session) || session.frameIndex == 0) {
+        return;
+    }
+    cout << "replayed " << session.frameIndex << " of " << session.frames.size() << " frames in "
+            << session.replayClock.getElapsedTime().asSeconds() << " s" << endl;
+    cout << "frame time avg " << session.totalWorkTime * 1000.f / static_cast<float>(session.frameIndex)
+            << " ms, max " << session.maxWorkTime * 1000.f << " ms" << endl;
+}
@@ -0,0 +1,117 @@
+// Слои с кешем в RenderTexture. Содержимое слоя рисуется в текстуру
+// только после invalidateLayer, а каждый кадр слой выводится одним
+// текстурированным прямоугольником. Неподвижный фон так не растеризуется
+// заново, а подвижные элементы рисуются поверх или в своих слоях, и
+// пересобирается только тот слой, что изменился. Слой покрывает только
+// свою область кадра: лишние пиксели полноэкранной текстуры стоили бы
+// заливки каждый кадр
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace sf;
+using namespace std;
+
+// Внутри слоя цвет сразу умножается на альфу: тогда полупрозрачные края
+// после сглаживания не темнеют при выводе слоя поверх кадра
+inline const BlendMode LAYER_BLEND(
+    BlendMode::Factor::SrcAlpha, BlendMode::Factor::OneMinusSrcAlpha, BlendMode::Equation::Add,
+    BlendMode::Factor::One, BlendMode::Factor::OneMinusSrcAlpha, BlendMode::Equation::Add
+);
+inline const BlendMode COMPOSITE_BLEND(BlendMode::Factor::One, BlendMode::Factor::OneMinusSrcAlpha);
+
+struct CachedLayer {
+    string name;
+    RenderTexture texture;
+    Color clearColor = Color::Transparent;
+    Vector2f position; // левый верхний угол области слоя в кадре
+    bool isAvailable = false; // false - текстуры нет, содержимое рисуется напрямую
+    bool isDirty = true;
+    uint64_t rebuilds = 0;
+    uint64_t reuses = 0; // кадры, выведенные без перерисовки слоя
+};
+
+// area - область кадра, которую покрывает слой; границы округляются
+// до целых пикселей, чтобы слой выводился без пересэмплирования.
+// false - текстуру нужного размера создать не удалось
+inline bool initLayer(
+    CachedLayer &layer,
+    const string &name,
+    const FloatRect &area,
+    const ContextSettings &settings = {}
+) {
+    layer.name = name;
+    layer.isDirty = true;
+    layer.position = {floor(area.position.x), floor(area.position.y)};
+    const Vector2u size = {
+        static_cast<unsigned>(ceil(area.position.x + area.size.x - layer.position.x)),
+        static_cast<unsigned>(ceil(area.position.y + area.size.y - layer.position.y))
+    };
+    layer.isAvailable = layer.texture.resize(size, settings);
+    if (!layer.isAvailable) {
+        cerr << "cannot create layer " << name << " " << size.x << "x" << size.y << endl;
+        return false;
+    }
+    // содержимое рисуется в координатах кадра
+    layer.texture.setView(View(FloatRect{layer.position, Vector2f(size)}));
+    return true;
+}
+
+inline void invalidateLayer(
+    CachedLayer &layer
+) {
+    layer.isDirty = true;
+}
+
+// Перерисовать слой, если он помечен. draw(target, states) рисует
+// содержимое слоя и передает states в каждый свой draw
+template <typename DrawLayer>
+void updateLayer(
+    CachedLayer &layer,
+    DrawLayer &&draw
+) {
+    if (!layer.isDirty) {
+        ++layer.reuses;
+        return;
+    }
+    layer.texture.clear(layer.clearColor);
+    draw(static_cast<RenderTarget &>(layer.texture), RenderStates(LAYER_BLEND));
+    layer.texture.display();
+    layer.isDirty = false;
+    ++layer.rebuilds;
+}
+
+// Вывести слой в кадр
+inline void drawLayer(
+    RenderTarget &target,
+    const CachedLayer &layer
+) {
+    Sprite sprite(layer.texture.getTexture());
+    sprite.setPosition(layer.position);
+    target.draw(sprite, RenderStates(COMPOSITE_BLEND));
+}
+
+// Обновить и вывести слой, а без текстуры нарисовать содержимое прямо в кадр
+template <typename DrawLayer>
+void drawCachedLayer(
+    RenderTarget &target,
+    CachedLayer &layer,
+    DrawLayer &&draw
+) {
+    if (!layer.isAvailable) {
+        draw(target, RenderStates::Default);
+        return;
+    }
+    updateLayer(layer, draw);
+    drawLayer(target, layer);
+}
+
+inline void printLayerReport(
+    const CachedLayer &layer
+) {
+    cout << "layer " << layer.name << ": rebuilt " << layer.rebuilds << ", reused " << layer.reuses << endl;
+}
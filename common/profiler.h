@@ -0,0 +1,209 @@
+// Профилировщик зон кадра. PROFILE_ZONE("update") засекает время до конца
+// блока и пишет зону в кольцевой буфер своего потока: без блокировок и
+// выделений памяти, пара чтений счетчика тактов и одна запись. При выходе
+// ProfilerDump сохраняет последние зоны в Chrome trace_event JSON
+// (открывается в chrome://tracing или ui.perfetto.dev) и печатает
+// p50/p95/p99 по каждой зоне
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <x86intrin.h>
+#define PROFILER_HAVE_RDTSC 1
+#endif
+
+using namespace std;
+
+// Зон в буфере каждого потока; старые перезаписываются
+constexpr size_t PROFILER_RING_SIZE = 1 << 16;
+
+struct ProfiledZone {
+    const char *name = nullptr; // строковый литерал, сравнивается по содержимому
+    uint64_t start = 0;
+    uint64_t end = 0;
+};
+
+// Пишет только свой поток; читается в ProfilerDump, когда потоки уже остановлены
+struct ProfilerRing {
+    vector<ProfiledZone> zones = vector<ProfiledZone>(PROFILER_RING_SIZE);
+    atomic<uint64_t> written{0};
+    uint32_t threadId = 0;
+};
+
+inline uint64_t readProfilerTicks() {
+#if defined(PROFILER_HAVE_RDTSC)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline uint64_t readProfilerNs() {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Такты и наносекунды на старте программы: по ним такты переводятся во время
+struct ProfilerOrigin {
+    uint64_t ticks = readProfilerTicks();
+    uint64_t ns = readProfilerNs();
+};
+
+inline const ProfilerOrigin PROFILER_ORIGIN;
+
+// Все буферы живут до конца программы, даже если их поток завершился
+inline mutex profilerRingsMutex;
+inline vector<unique_ptr<ProfilerRing>> profilerRings;
+
+// Блокировка только при первой зоне потока
+inline ProfilerRing *registerProfilerThread() {
+    lock_guard lock(profilerRingsMutex);
+    profilerRings.push_back(make_unique<ProfilerRing>());
+    profilerRings.back()->threadId = static_cast<uint32_t>(profilerRings.size());
+    return profilerRings.back().get();
+}
+
+inline ProfilerRing &getProfilerRing() {
+    thread_local ProfilerRing *ring = registerProfilerThread();
+    return *ring;
+}
+
+struct ProfileScope {
+    const char *name;
+    uint64_t start;
+
+    explicit ProfileScope(const char *zoneName) : name(zoneName), start(readProfilerTicks()) {
+    }
+
+    ~ProfileScope() {
+        const uint64_t end = readProfilerTicks();
+        ProfilerRing &ring = getProfilerRing();
+        const uint64_t index = ring.written.load(memory_order_relaxed);
+        ring.zones[index & (PROFILER_RING_SIZE - 1)] = {name, start, end};
+        ring.written.store(index + 1, memory_order_release);
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) const ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name)
+
+// Наносекунд на такт по двум замерам: на старте и сейчас
+inline double getNsPerTick() {
+#if defined(PROFILER_HAVE_RDTSC)
+    const uint64_t ticks = readProfilerTicks() - PROFILER_ORIGIN.ticks;
+    const uint64_t ns = readProfilerNs() - PROFILER_ORIGIN.ns;
+    return ticks > 0 ? static_cast<double>(ns) / static_cast<double>(ticks) : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+// Зоны кольца в порядке записи: не больше PROFILER_RING_SIZE последних
+inline vector<ProfiledZone> getRecordedZones(
+    const ProfilerRing &ring
+) {
+    const uint64_t written = ring.written.load(memory_order_acquire);
+    const uint64_t first = written > PROFILER_RING_SIZE ? written - PROFILER_RING_SIZE : 0;
+    vector<ProfiledZone> zones;
+    zones.reserve(written - first);
+    for (uint64_t i = first; i < written; ++i) {
+        zones.push_back(ring.zones[i & (PROFILER_RING_SIZE - 1)]);
+    }
+    return zones;
+}
+
+inline void writeChromeTrace(
+    const string &path,
+    const double nsPerTick
+) {
+    ofstream output(path);
+    if (!output) {
+        cerr << "cannot write profile: " << path << endl;
+        return;
+    }
+    output << fixed << setprecision(3) << "{\"traceEvents\": [\n";
+    bool isFirst = true;
+    for (const unique_ptr<ProfilerRing> &ring: profilerRings) {
+        for (const ProfiledZone &zone: getRecordedZones(*ring)) {
+            // время в микросекундах от старта программы
+            const double start = static_cast<double>(zone.start - PROFILER_ORIGIN.ticks) * nsPerTick / 1000.0;
+            const double duration = static_cast<double>(zone.end - zone.start) * nsPerTick / 1000.0;
+            output << (isFirst ? "" : ",\n")
+                    << "  {\"name\": \"" << zone.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->threadId
+                    << ", \"ts\": " << start << ", \"dur\": " << duration << "}";
+            isFirst = false;
+        }
+    }
+    output << "\n]}\n";
+}
+
+// Перцентиль уже отсортированных длительностей
+inline double getPercentile(
+    const vector<double> &sorted,
+    const double percent
+) {
+    const auto index = static_cast<size_t>(percent / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+inline void printZoneStatistics(
+    ostream &output,
+    const double nsPerTick
+) {
+    map<string, vector<double>> durations; // микросекунды, по имени зоны
+    for (const unique_ptr<ProfilerRing> &ring: profilerRings) {
+        for (const ProfiledZone &zone: getRecordedZones(*ring)) {
+            durations[zone.name].push_back(static_cast<double>(zone.end - zone.start) * nsPerTick / 1000.0);
+        }
+    }
+
+    output << left << setw(16) << "zone" << right
+            << setw(10) << "count" << setw(12) << "p50 us" << setw(12) << "p95 us"
+            << setw(12) << "p99 us" << setw(12) << "max us" << endl;
+    output << fixed << setprecision(1);
+    for (auto &[name, zoneDurations]: durations) {
+        sort(zoneDurations.begin(), zoneDurations.end());
+        output << left << setw(16) << name << right
+                << setw(10) << zoneDurations.size()
+                << setw(12) << getPercentile(zoneDurations, 50)
+                << setw(12) << getPercentile(zoneDurations, 95)
+                << setw(12) << getPercentile(zoneDurations, 99)
+                << setw(12) << zoneDurations.back() << endl;
+    }
+}
+
+// Создается первым в main: при выходе из main, когда остальные объекты
+// и потоки уже разрушены, пишет <name>_trace.json и таблицу зон в stdout
+struct ProfilerDump {
+    string name;
+
+    explicit ProfilerDump(string programName) : name(std::move(programName)) {
+    }
+
+    ~ProfilerDump() {
+        lock_guard lock(profilerRingsMutex);
+        const double nsPerTick = getNsPerTick();
+        writeChromeTrace(name + "_trace.json", nsPerTick);
+        printZoneStatistics(cout, nsPerTick);
+    }
+
+    ProfilerDump(const ProfilerDump &) = delete;
+    ProfilerDump &operator=(const ProfilerDump &) = delete;
+};
@@ -0,0 +1,114 @@
+// Перерисовка только по изменению для статичных сцен. Пока сцена чистая,
+// цикл не крутится вхолостую, а спит в waitEvent; кадр рисуется, когда
+// событие или анимация пометили сцену грязной (markDirty). Изменение размера
+// и возврат фокуса помечают сцену сами. --continuous возвращает прежний
+// цикл с отрисовкой каждого кадра, для сравнения
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "frame_pacer.h"
+#include "profiler.h"
+
+using namespace sf;
+using namespace std;
+
+struct RedrawGate {
+    using Clock = chrono::steady_clock;
+
+    bool isContinuous = false;
+    bool isDirty = true; // первый кадр рисуется всегда
+    bool hasWaited = false; // в этом кадре уже ждали событие
+    bool hasIdled = false; // с прошлой отрисовки был простой
+
+    uint64_t renderedFrames = 0;
+    uint64_t idleWakeups = 0; // проснулись, а перерисовывать нечего
+    Clock::duration idleTime{};
+};
+
+inline void initRedrawGate(
+    RedrawGate &gate,
+    const vector<string> &args
+) {
+    gate.isContinuous = find(args.begin(), args.end(), "--continuous") != args.end();
+}
+
+inline void markDirty(
+    RedrawGate &gate
+) {
+    gate.isDirty = true;
+}
+
+// Замена window.pollEvent(). На чистой сцене первый вызов за кадр блокирует
+// до следующего события, остальные только забирают накопившиеся
+inline optional<Event> pollRedrawEvent(
+    RedrawGate &gate,
+    RenderWindow &window
+) {
+    optional<Event> event;
+    if (gate.isContinuous || gate.isDirty || gate.hasWaited) {
+        event = window.pollEvent();
+    } else {
+        PROFILE_ZONE("idle");
+        gate.hasWaited = true;
+        gate.hasIdled = true;
+        const RedrawGate::Clock::time_point start = RedrawGate::Clock::now();
+        event = window.waitEvent();
+        gate.idleTime += RedrawGate::Clock::now() - start;
+    }
+    if (event && (event->is<Event::Resized>() || event->is<Event::FocusGained>())) {
+        markDirty(gate);
+    }
+    return event;
+}
+
+// Вызывается после обработки событий: false - кадр пропускается целиком,
+// вместе с waitNextFrame
+inline bool shouldRedraw(
+    RedrawGate &gate,
+    FramePacer &pacer
+) {
+    gate.hasWaited = false;
+    if (gate.isContinuous) {
+        return true;
+    }
+    if (!gate.isDirty) {
+        ++gate.idleWakeups;
+        return false;
+    }
+    if (gate.hasIdled) {
+        resyncFramePacer(pacer);
+        gate.hasIdled = false;
+    }
+    return true;
+}
+
+// Вызывается после display()
+inline void finishRedraw(
+    RedrawGate &gate
+) {
+    gate.isDirty = false;
+    ++gate.renderedFrames;
+}
+
+// Пропущенные кадры - сколько кадров нарисовал бы за время простоя цикл
+// с частотой pacer
+inline void printRedrawReport(
+    const RedrawGate &gate,
+    const FramePacer &pacer
+) {
+    if (gate.isContinuous) {
+        return;
+    }
+    const auto skippedFrames = static_cast<uint64_t>(gate.idleTime / pacer.period);
+    cout << "redraw on change: " << gate.renderedFrames << " frames drawn, " << skippedFrames
+            << " skipped, idle " << chrono::duration<double>(gate.idleTime).count()
+            << " s, woken without redraw " << gate.idleWakeups << endl;
+}
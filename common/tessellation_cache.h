@@ -0,0 +1,159 @@
+// Кеш разбиения кривых на точки. Эллипс или роза с одними и теми же
+// параметрами и числом точек считаются один раз, дальше все фигуры получают
+// общий неизменяемый буфер точек без sin/cos на каждый экземпляр. Число
+// точек можно подобрать по радиусу на экране: так, чтобы хорда отходила
+// от настоящей кривой не больше чем на заданную долю пикселя
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace sf;
+using namespace std;
+
+// отклонение хорды от кривой, в пикселях
+constexpr float DEFAULT_PIXEL_TOLERANCE = 0.25f;
+constexpr size_t MIN_CURVE_POINTS = 8;
+constexpr size_t MAX_CURVE_POINTS = 4096;
+
+enum class CurveType : uint8_t {
+    Ellipse, // x = a sin t, y = b cos t
+    Rose // r = a sin(b t), x = r sin t, y = r cos t
+};
+
+// Параметры сравниваются точно, без округления
+struct CurveKey {
+    CurveType type = CurveType::Ellipse;
+    float a = 0;
+    float b = 0;
+    uint32_t pointCount = 0;
+
+    bool operator==(const CurveKey &other) const {
+        return type == other.type && a == other.a && b == other.b && pointCount == other.pointCount;
+    }
+};
+
+struct CurveKeyHash {
+    size_t operator()(const CurveKey &key) const {
+        uint32_t a;
+        uint32_t b;
+        memcpy(&a, &key.a, sizeof(a));
+        memcpy(&b, &key.b, sizeof(b));
+        uint64_t hash = static_cast<uint64_t>(key.type) * 0x9E3779B97F4A7C15ull;
+        for (const uint64_t part: {uint64_t{a}, uint64_t{b}, uint64_t{key.pointCount}}) {
+            hash = (hash ^ part) * 0xBF58476D1CE4E5B9ull;
+            hash ^= hash >> 31;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+using CurvePoints = shared_ptr<const vector<Vector2f>>;
+
+struct TessellationCache {
+    unordered_map<CurveKey, CurvePoints, CurveKeyHash> curves;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Число точек для замкнутой кривой: maxRadius - наибольшее расстояние
+// от центра (задает длину шага по параметру), minCurvatureRadius -
+// наименьший радиус кривизны, где хорда отходит от кривой сильнее всего.
+// Отклонение хорды длины l на дуге радиуса rho равно l^2 / (8 rho)
+inline size_t getCurvePointCount(
+    const float maxRadius,
+    const float minCurvatureRadius,
+    const float tolerance
+) {
+    if (maxRadius <= 0.f || minCurvatureRadius <= 0.f) {
+        return MIN_CURVE_POINTS;
+    }
+    const float step = sqrt(8.f * minCurvatureRadius * tolerance) / maxRadius;
+    const auto count = static_cast<size_t>(ceil(2.f * static_cast<float>(M_PI) / step));
+    return clamp(count, MIN_CURVE_POINTS, MAX_CURVE_POINTS);
+}
+
+// radius - полуоси на экране, с учетом масштаба
+inline size_t getEllipsePointCount(
+    const Vector2f &radius,
+    const float tolerance = DEFAULT_PIXEL_TOLERANCE
+) {
+    const float major = max(abs(radius.x), abs(radius.y));
+    const float minor = min(abs(radius.x), abs(radius.y));
+    // кривизна эллипса наибольшая на концах большой оси: rho = b^2 / a
+    return getCurvePointCount(major, major > 0.f ? minor * minor / major : 0.f, tolerance);
+}
+
+// У розы кривизна наибольшая на кончиках лепестков: rho = R / (1 + k^2)
+inline size_t getRosePointCount(
+    const float radius,
+    const float petalCount,
+    const float tolerance = DEFAULT_PIXEL_TOLERANCE
+) {
+    return getCurvePointCount(abs(radius), abs(radius) / (1.f + petalCount * petalCount), tolerance);
+}
+
+inline vector<Vector2f> tessellateCurve(
+    const CurveKey &key
+) {
+    vector<Vector2f> points(key.pointCount);
+    for (uint32_t i = 0; i < key.pointCount; ++i) {
+        const float angle = static_cast<float>(2 * M_PI * i) / static_cast<float>(key.pointCount);
+        if (key.type == CurveType::Ellipse) {
+            points[i] = {key.a * sin(angle), key.b * cos(angle)};
+        } else {
+            const float radius = key.a * sin(key.b * angle);
+            points[i] = {radius * sin(angle), radius * cos(angle)};
+        }
+    }
+    return points;
+}
+
+inline CurvePoints getCurvePoints(
+    TessellationCache &cache,
+    const CurveKey &key
+) {
+    const auto it = cache.curves.find(key);
+    if (it != cache.curves.end()) {
+        ++cache.hits;
+        return it->second;
+    }
+    ++cache.misses;
+    CurvePoints points = make_shared<const vector<Vector2f>>(tessellateCurve(key));
+    cache.curves.emplace(key, points);
+    return points;
+}
+
+inline CurvePoints getEllipsePoints(
+    TessellationCache &cache,
+    const Vector2f &radius,
+    const size_t pointCount
+) {
+    return getCurvePoints(cache, {CurveType::Ellipse, radius.x, radius.y, static_cast<uint32_t>(pointCount)});
+}
+
+inline CurvePoints getRosePoints(
+    TessellationCache &cache,
+    const float radius,
+    const float petalCount,
+    const size_t pointCount
+) {
+    return getCurvePoints(cache, {CurveType::Rose, radius, petalCount, static_cast<uint32_t>(pointCount)});
+}
+
+// Скопировать готовые точки в фигуру; тригонометрии здесь нет
+inline void setShapePoints(
+    ConvexShape &shape,
+    const vector<Vector2f> &points
+) {
+    shape.setPointCount(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        shape.setPoint(i, points[i]);
+    }
+}
@@ -0,0 +1,190 @@
+// Иерархическое колесо таймеров. Время идет целыми тиками; таймер лежит
+// в ячейке уровня, чья ячейка покрывает его срок: нижний уровень - по
+// тику на ячейку, каждый следующий в WHEEL_SLOTS раз грубее. Постановка
+// и отмена - вставка и удаление из двусвязного списка ячейки, O(1).
+// Продвижение на тик срабатывает одну ячейку нижнего уровня, а раз в
+// WHEEL_SLOTS тиков раскладывает ниже одну ячейку следующего уровня,
+// так что работа за кадр зависит от числа сработавших таймеров, а не
+// от числа поставленных
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+constexpr uint32_t WHEEL_BITS = 8;
+constexpr uint32_t WHEEL_SLOTS = 1u << WHEEL_BITS;
+constexpr uint32_t WHEEL_LEVELS = 4; // 2^32 тиков вперед
+constexpr uint32_t NO_TIMER = UINT32_MAX;
+
+// Действителен, пока таймер не сработал и не отменен. Узлы занимаются
+// снова, поэтому старый дескриптор отличается от нового по поколению
+struct TimerHandle {
+    uint32_t node = NO_TIMER;
+    uint32_t generation = 0;
+};
+
+struct TimerNode {
+    uint64_t deadline = 0;
+    uint32_t payload = 0;
+    uint32_t prev = NO_TIMER;
+    uint32_t next = NO_TIMER; // у свободного узла - следующий свободный
+    uint32_t slot = NO_TIMER; // NO_TIMER - узел свободен
+    uint32_t generation = 0; // растет при каждом освобождении узла
+};
+
+struct TimingWheel {
+    uint64_t now = 0; // последний обработанный тик
+    vector<uint32_t> heads = vector<uint32_t>(WHEEL_LEVELS * WHEEL_SLOTS, NO_TIMER);
+    vector<TimerNode> nodes;
+    uint32_t firstFree = NO_TIMER;
+    size_t activeCount = 0;
+
+    uint64_t fired = 0;
+    uint64_t cascaded = 0; // перекладываний на уровень ниже
+};
+
+// earliest - самый ранний тик, который еще будет обработан: при постановке
+// снаружи это now + 1, при раскладке внутри продвижения - сам now
+inline void linkTimer(
+    TimingWheel &wheel,
+    const uint32_t id,
+    const uint64_t earliest
+) {
+    TimerNode &node = wheel.nodes[id];
+    const uint64_t deadline = max(node.deadline, earliest);
+
+    uint32_t level = 0;
+    while (level + 1 < WHEEL_LEVELS
+        && (deadline >> (WHEEL_BITS * level)) - (wheel.now >> (WHEEL_BITS * level)) >= WHEEL_SLOTS) {
+        ++level;
+    }
+    const uint32_t shift = WHEEL_BITS * level;
+    // дальше верхнего уровня: в его последнюю ячейку, оттуда таймер
+    // разложится заново
+    const uint64_t position = min(deadline >> shift, (wheel.now >> shift) + WHEEL_SLOTS - 1);
+    const uint32_t slot = level * WHEEL_SLOTS + static_cast<uint32_t>(position & (WHEEL_SLOTS - 1));
+
+    node.slot = slot;
+    node.prev = NO_TIMER;
+    node.next = wheel.heads[slot];
+    if (node.next != NO_TIMER) {
+        wheel.nodes[node.next].prev = id;
+    }
+    wheel.heads[slot] = id;
+}
+
+inline void unlinkTimer(
+    TimingWheel &wheel,
+    const uint32_t id
+) {
+    TimerNode &node = wheel.nodes[id];
+    if (node.prev != NO_TIMER) {
+        wheel.nodes[node.prev].next = node.next;
+    } else {
+        wheel.heads[node.slot] = node.next;
+    }
+    if (node.next != NO_TIMER) {
+        wheel.nodes[node.next].prev = node.prev;
+    }
+}
+
+inline void freeTimer(
+    TimingWheel &wheel,
+    const uint32_t id
+) {
+    TimerNode &node = wheel.nodes[id];
+    node.slot = NO_TIMER;
+    ++node.generation;
+    node.next = wheel.firstFree;
+    wheel.firstFree = id;
+    --wheel.activeCount;
+}
+
+// Таймер на тик deadline; прошедший срок срабатывает на следующем тике
+inline TimerHandle scheduleTimer(
+    TimingWheel &wheel,
+    const uint64_t deadline,
+    const uint32_t payload
+) {
+    uint32_t id = wheel.firstFree;
+    if (id != NO_TIMER) {
+        wheel.firstFree = wheel.nodes[id].next;
+    } else {
+        id = static_cast<uint32_t>(wheel.nodes.size());
+        wheel.nodes.emplace_back();
+    }
+    wheel.nodes[id].deadline = deadline;
+    wheel.nodes[id].payload = payload;
+    linkTimer(wheel, id, wheel.now + 1);
+    ++wheel.activeCount;
+    return {id, wheel.nodes[id].generation};
+}
+
+// false - таймер уже сработал или отменен, даже если его узел занят
+// другим таймером
+inline bool cancelTimer(
+    TimingWheel &wheel,
+    const TimerHandle &handle
+) {
+    if (handle.node >= wheel.nodes.size()
+        || wheel.nodes[handle.node].generation != handle.generation
+        || wheel.nodes[handle.node].slot == NO_TIMER) {
+        return false;
+    }
+    unlinkTimer(wheel, handle.node);
+    freeTimer(wheel, handle.node);
+    return true;
+}
+
+// Переложить ячейку уровня ниже: все ее таймеры истекают в ближайшие
+// WHEEL_SLOTS^level тиков
+inline void cascadeSlot(
+    TimingWheel &wheel,
+    const uint32_t level
+) {
+    const uint32_t slot = level * WHEEL_SLOTS
+        + static_cast<uint32_t>((wheel.now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+    uint32_t id = wheel.heads[slot];
+    wheel.heads[slot] = NO_TIMER;
+    while (id != NO_TIMER) {
+        const uint32_t next = wheel.nodes[id].next;
+        linkTimer(wheel, id, wheel.now);
+        ++wheel.cascaded;
+        id = next;
+    }
+}
+
+// Продвинуть колесо до тика target включительно; данные сработавших
+// таймеров дописываются в fired в порядке сроков
+inline void advanceTimingWheel(
+    TimingWheel &wheel,
+    const uint64_t target,
+    vector<uint32_t> &fired
+) {
+    while (wheel.now < target) {
+        if (wheel.activeCount == 0) {
+            wheel.now = target;
+            return;
+        }
+        ++wheel.now;
+        for (uint32_t level = WHEEL_LEVELS - 1; level > 0; --level) {
+            if ((wheel.now & ((uint64_t{1} << (WHEEL_BITS * level)) - 1)) == 0) {
+                cascadeSlot(wheel, level);
+            }
+        }
+
+        const uint32_t slot = static_cast<uint32_t>(wheel.now & (WHEEL_SLOTS - 1));
+        uint32_t id = wheel.heads[slot];
+        wheel.heads[slot] = NO_TIMER;
+        while (id != NO_TIMER) {
+            const uint32_t next = wheel.nodes[id].next;
+            fired.push_back(wheel.nodes[id].payload);
+            freeTimer(wheel, id);
+            ++wheel.fired;
+            id = next;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// Тройной буфер без блокировок для передачи состояния из потока симуляции
+// в поток отрисовки. Писатель заполняет свой буфер и публикует его, читатель
+// забирает последний опубликованный. Никто никого не ждет: писатель не
+// трогает буфер читателя, а промежуточные снимки просто перезаписываются
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+template <typename T>
+struct TripleBuffer {
+    // в middle лежит индекс среднего буфера и флаг "опубликован новый снимок"
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    T buffers[3];
+    atomic<uint8_t> middle{1};
+    uint8_t back = 0; // только писатель
+    uint8_t front = 2; // только читатель
+
+    // Буфер писателя: заполняется целиком перед publish()
+    T &getBack() {
+        return buffers[back];
+    }
+
+    // Отдать заполненный буфер читателю и взять себе освободившийся средний
+    void publish() {
+        back = middle.exchange(back | FRESH_BIT, memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Забрать последний опубликованный снимок. false - нового не было,
+    // getFront() остается прежним
+    bool acquire() {
+        if (!(middle.load(memory_order_relaxed) & FRESH_BIT)) {
+            return false;
+        }
+        front = middle.exchange(front, memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // Буфер читателя: не меняется до следующего acquire()
+    const T &getFront() const {
+        return buffers[front];
+    }
+};
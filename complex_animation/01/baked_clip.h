@@ -0,0 +1,137 @@
+// Запеченный зацикленный клип. Весь цикл анимации один раз снимается
+// с заданной частотой в плоский буфер кадров: в кадре значения всех
+// каналов подряд. Воспроизведение - индекс кадра по времени и линейная
+// интерполяция соседних кадров, без этапов и дорожек, поэтому перемотка
+// в любой момент стоит O(1). Один клип могут читать много экземпляров,
+// каждый со своим сдвигом фазы
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+constexpr float QUANTIZATION_LEVELS = 65535.f;
+
+struct BakedClip {
+    size_t channelCount = 0;
+    size_t frameCount = 0;
+    float duration = 0;
+    float sampleRate = 0;
+
+    bool isQuantized = false;
+    vector<float> frames;
+    // 16 бит на значение: minimum + code * step, свои границы у каждого канала
+    vector<uint16_t> quantizedFrames;
+    vector<float> minimum;
+    vector<float> step;
+};
+
+// sample(time, values) пишет значения channelCount каналов в момент time.
+// Кадры берутся в моменты i / sampleRate на [0, duration); последний
+// кадр интерполируется к первому, как и сама анимация по кругу. Для этого
+// в цикле должно быть целое число кадров, поэтому частота округляется до
+// ближайшей такой: иначе последний интервал короче остальных, и на стыке
+// цикла анимация прыгает
+template <typename Sample>
+void bakeClip(
+    BakedClip &clip,
+    const size_t channelCount,
+    const float duration,
+    const float sampleRate,
+    const bool isQuantized,
+    Sample &&sample
+) {
+    clip.channelCount = channelCount;
+    clip.duration = duration;
+    clip.frameCount = max<size_t>(1, static_cast<size_t>(round(duration * sampleRate)));
+    clip.sampleRate = static_cast<float>(clip.frameCount) / duration;
+    clip.isQuantized = isQuantized;
+    clip.frames.resize(clip.frameCount * channelCount);
+    for (size_t frame = 0; frame < clip.frameCount; ++frame) {
+        sample(static_cast<float>(frame) / clip.sampleRate, &clip.frames[frame * channelCount]);
+    }
+    if (!isQuantized) {
+        clip.quantizedFrames.clear();
+        return;
+    }
+
+    clip.minimum.assign(channelCount, INFINITY);
+    vector<float> maximum(channelCount, -INFINITY);
+    for (size_t i = 0; i < clip.frames.size(); ++i) {
+        clip.minimum[i % channelCount] = min(clip.minimum[i % channelCount], clip.frames[i]);
+        maximum[i % channelCount] = max(maximum[i % channelCount], clip.frames[i]);
+    }
+    clip.step.resize(channelCount);
+    for (size_t channel = 0; channel < channelCount; ++channel) {
+        clip.step[channel] = (maximum[channel] - clip.minimum[channel]) / QUANTIZATION_LEVELS;
+    }
+
+    clip.quantizedFrames.resize(clip.frames.size());
+    for (size_t i = 0; i < clip.frames.size(); ++i) {
+        const size_t channel = i % channelCount;
+        const float code = clip.step[channel] > 0.f
+            ? round((clip.frames[i] - clip.minimum[channel]) / clip.step[channel])
+            : 0.f;
+        clip.quantizedFrames[i] = static_cast<uint16_t>(code);
+    }
+    // полные значения нужны только при запекании
+    clip.frames.clear();
+    clip.frames.shrink_to_fit();
+}
+
+inline float getFrameValue(
+    const BakedClip &clip,
+    const size_t frame,
+    const size_t channel
+) {
+    const size_t i = frame * clip.channelCount + channel;
+    if (clip.isQuantized) {
+        return clip.minimum[channel] + static_cast<float>(clip.quantizedFrames[i]) * clip.step[channel];
+    }
+    return clip.frames[i];
+}
+
+// Значения каналов [firstChannel, firstChannel + count) в момент time;
+// время любое, в том числе отрицательное или за концом цикла
+inline void sampleClip(
+    const BakedClip &clip,
+    const float time,
+    const size_t firstChannel,
+    const size_t count,
+    float *values
+) {
+    float cycleTime = fmod(time, clip.duration);
+    if (cycleTime < 0.f) {
+        cycleTime += clip.duration;
+    }
+    const float position = cycleTime * clip.sampleRate;
+    const size_t frame = min(static_cast<size_t>(position), clip.frameCount - 1);
+    const size_t nextFrame = frame + 1 < clip.frameCount ? frame + 1 : 0;
+    const float t = position - static_cast<float>(frame);
+
+    for (size_t i = 0; i < count; ++i) {
+        const float from = getFrameValue(clip, frame, firstChannel + i);
+        const float to = getFrameValue(clip, nextFrame, firstChannel + i);
+        values[i] = from + (to - from) * t;
+    }
+}
+
+inline size_t getClipBytes(
+    const BakedClip &clip
+) {
+    return clip.isQuantized
+        ? clip.quantizedFrames.size() * sizeof(uint16_t) + (clip.minimum.size() + clip.step.size()) * sizeof(float)
+        : clip.frames.size() * sizeof(float);
+}
+
+inline void printClipReport(
+    const BakedClip &clip
+) {
+    cout << "baked clip: " << clip.frameCount << " frames at " << clip.sampleRate << " Hz, "
+        << clip.channelCount << " channels, " << (clip.isQuantized ? "16-bit" : "float") << ", "
+        << getClipBytes(clip) << " bytes" << endl;
+}
@@ -0,0 +1,89 @@
+// Хореография блоков: размеры сцены и этапы анимации. Общая для 01
+// и для 02, где та же анимация идет на сотнях тысяч блоков
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "timeline.h"
+
+using namespace sf;
+using namespace std;
+
+constexpr float BASE_SIDE = 50.f;
+constexpr Vector2f BASE_SIZE = {BASE_SIDE, BASE_SIDE};
+constexpr unsigned WINDOW_WIDTH = 1000;
+constexpr unsigned WINDOW_HEIGHT = 800;
+constexpr Vector2f WINDOW_CENTER = {1000 / 2.f, 800 / 2.f};
+constexpr Vector2f INITIAL_POSITION = {BASE_SIDE / 2.f, BASE_SIDE / 2.f};
+constexpr size_t BLOCKS_COUNT = 6;
+constexpr size_t ANIMATION_STEPS = 5;
+constexpr float ANIMATION_DURATION = 1.f;
+constexpr float SPACING = 80.f;
+constexpr float HALF_COMPENSATION_FACTOR = 0.5f;
+
+constexpr Color DEFAULT_COLOR = {102, 0, 102, 255};
+
+// параметры этапов
+constexpr float SHIFT = 200.f;
+constexpr float TOTAL_SPAN = (BLOCKS_COUNT - 1) * SPACING;
+constexpr float DIMMED_ALPHA = DEFAULT_COLOR.a / 2;
+constexpr float FULL_ALPHA = DEFAULT_COLOR.a;
+constexpr float STACK_SPACING = BASE_SIDE * HALF_COMPENSATION_FACTOR + SPACING;
+
+inline Vector2f getInitialPosition(
+    const size_t index
+) {
+    return {INITIAL_POSITION.x, INITIAL_POSITION.y + static_cast<float>(index) * SPACING};
+}
+
+// Сценарий анимации: блоки отъезжают вправо, собираются в столбик в центре
+// окна и тускнеют, выстраиваются в ряд, поднимаются и сплющиваются,
+// расходятся лесенкой и возвращаются на места
+inline vector<StageSpec> createChoreography() {
+    constexpr PointRule INITIAL_POSITIONS = {
+        {Anchor::Absolute, INITIAL_POSITION.x, 0.f},
+        {Anchor::Absolute, INITIAL_POSITION.y, SPACING}
+    };
+
+    vector<StageSpec> stages(ANIMATION_STEPS + 1);
+    // вправо
+    stages[0].position = PointRule{
+        {Anchor::Absolute, INITIAL_POSITION.x + SHIFT, 0.f},
+        {Anchor::Absolute, INITIAL_POSITION.y, SPACING}
+    };
+    // столбик в центре окна
+    stages[1].position = PointRule{
+        {Anchor::Absolute, WINDOW_CENTER.x, 0.f},
+        {Anchor::Absolute, WINDOW_CENTER.y - TOTAL_SPAN * HALF_COMPENSATION_FACTOR, SPACING}
+    };
+    stages[1].alpha = AxisRule{Anchor::Absolute, DIMMED_ALPHA, 0.f};
+    // ряд по горизонтали
+    stages[2].position = PointRule{
+        {Anchor::Absolute, WINDOW_CENTER.x - TOTAL_SPAN / 2.f, SPACING},
+        {Anchor::Absolute, WINDOW_CENTER.y, 0.f}
+    };
+    // вверх со сплющиванием
+    stages[3].position = PointRule{
+        {Anchor::StageStart, 0.f, 0.f},
+        {Anchor::StageStart, -SHIFT, 0.f}
+    };
+    stages[3].size = PointRule{
+        {Anchor::Absolute, BASE_SIZE.x, 0.f},
+        {Anchor::Absolute, BASE_SIZE.y * HALF_COMPENSATION_FACTOR, 0.f}
+    };
+    // лесенка от левого блока ряда
+    stages[4].position = PointRule{
+        {Anchor::Absolute, WINDOW_CENTER.x - TOTAL_SPAN * HALF_COMPENSATION_FACTOR, 0.f},
+        {Anchor::StageStart, 0.f, STACK_SPACING}
+    };
+    // на начальные места
+    stages[5].position = INITIAL_POSITIONS;
+    stages[5].size = PointRule{{Anchor::Absolute, BASE_SIZE.x, 0.f}, {Anchor::Absolute, BASE_SIZE.y, 0.f}};
+    stages[5].alpha = AxisRule{Anchor::Absolute, FULL_ALPHA, 0.f};
+
+    for (StageSpec &stage: stages) {
+        stage.duration = ANIMATION_DURATION;
+    }
+    return stages;
+}
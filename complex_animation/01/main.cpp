@@ -1,302 +1,193 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "../../common/command_line.h"
+#include "../../common/triple_buffer.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "baked_clip.h"
+#include "choreography.h"
+#include "script.h"
+#include "timeline.h"
+#include "tracked_shape.h"
 
 using namespace sf;
 using namespace std;
 
-constexpr float BASE_SIDE = 50.f;
-constexpr Vector2f BASE_SIZE = {BASE_SIDE, BASE_SIDE};
-constexpr unsigned WINDOW_WIDTH = 1000;
-constexpr unsigned WINDOW_HEIGHT = 800;
-constexpr Vector2f WINDOW_CENTER = {1000 / 2.f, 800 / 2.f};
-constexpr Vector2f INITIAL_POSITION = {BASE_SIDE / 2.f, BASE_SIDE / 2.f};
-constexpr size_t BLOCKS_COUNT = 6;
-constexpr size_t ANIMATION_STEPS = 5;
-constexpr float ANIMATION_DURATION = 1.f;
-constexpr float SPACING = 80.f;
-constexpr float HALF_COMPENSATION_FACTOR = 0.5f;
-
-constexpr Color DEFAULT_COLOR = {102, 0, 102, 255};
-
-enum class AnimationStage {
-    MoveRight,
-    MoveToWindowCenter,
-    MoveToHorizontal,
-    MoveTop,
-    MoveToVerticalStack,
-    MoveToInitialPosition,
-    Finished
-};
+// в режиме --pipeline анимация считается не чаще этого
+constexpr float SIMULATION_STEP = 1.f / 240.f;
+// позиция, размер и прозрачность блока в запеченном клипе
+constexpr size_t CLIP_CHANNELS_PER_BLOCK = 5;
 
 struct Block {
-    RectangleShape shape;
+    TrackedRect rect;
     Color baseColor = DEFAULT_COLOR;
 
-    AnimationStage stage = AnimationStage::MoveRight;
-    float stageStartTime = 0.f;
-
     size_t index{};
-    Vector2f stageStartPos; // начало этапа
-    Vector2f stageStartSize;
+    BlockTimeline timeline;
+    float phase = 0; // сдвиг блока по времени клипа
+    Actor actor; // каналы блока под управлением сценария
 };
 
-// lerp
-Vector2f linearInterpolation(
-    const Vector2f &a,
-    const Vector2f &b,
-    const float time
-) {
-    return a + (b - a) * time;
-}
-
-Vector2f getInitialPosition(
-    const size_t index
-) {
-    return {INITIAL_POSITION.x, INITIAL_POSITION.y + static_cast<float>(index) * SPACING};
-}
-
 void createBlock(
-    vector<Block> &blocks
+    vector<Block> &blocks,
+    const vector<StageSpec> &choreography
 ) {
     for (size_t i = 0; i < BLOCKS_COUNT; ++i) {
         Block b;
 
-        b.shape.setPosition(getInitialPosition(i));
-        b.shape.setSize(BASE_SIZE);
-        b.shape.setFillColor(b.baseColor);
-        b.shape.setOrigin(BASE_SIZE / 2.f);
+        initTrackedRect(b.rect, BASE_SIZE, BASE_SIZE / 2.f, getInitialPosition(i), b.baseColor);
 
         b.index = i;
-        b.stageStartPos = getInitialPosition(i);
-        b.stageStartSize = BASE_SIZE;
+        b.timeline = buildTimeline(choreography, i, {getInitialPosition(i), BASE_SIZE, static_cast<float>(b.baseColor.a)});
+        b.actor.position = {getInitialPosition(i), getInitialPosition(i)};
+        b.actor.size = {BASE_SIZE, BASE_SIZE};
+        b.actor.alpha = {static_cast<float>(b.baseColor.a), static_cast<float>(b.baseColor.a)};
 
         blocks.push_back(b);
     }
 }
 
-void pollEvents(
-    RenderWindow &window
+// Снять цикл всех блоков в один клип. Если на этап приходится целое число
+// кадров, кадры попадают точно на границы этапов, и интерполяция между
+// ними не теряет точности
+void bakeBlocks(
+    BakedClip &clip,
+    vector<Block> blocks,
+    const float sampleRate,
+    const bool isQuantized
 ) {
-    while (const auto event = window.pollEvent()) {
-        if (event->is<Event::Closed>()) {
-            window.close();
+    bakeClip(
+        clip,
+        blocks.size() * CLIP_CHANNELS_PER_BLOCK,
+        blocks.front().timeline.duration,
+        sampleRate,
+        isQuantized,
+        [&](const float time, float *values) {
+            for (Block &block: blocks) {
+                const BlockState state = evaluateTimeline(block.timeline, time);
+                float *blockValues = values + block.index * CLIP_CHANNELS_PER_BLOCK;
+                blockValues[0] = state.position.x;
+                blockValues[1] = state.position.y;
+                blockValues[2] = state.size.x;
+                blockValues[3] = state.size.y;
+                blockValues[4] = state.alpha;
+            }
         }
-    }
-}
-
-float getNormalizedTime(
-    const Block &block,
-    const float capacityTime,
-    const float stageDuration = ANIMATION_DURATION
-) {
-    const float elapsedTime = capacityTime - block.stageStartTime;
-    return min(elapsedTime / stageDuration, 1.f);
-}
-
-void updatePosition(
-    Block &block,
-    const Vector2f &endPosition,
-    const float normalizedTime
-) {
-    block.shape.setPosition(
-        linearInterpolation(
-            block.stageStartPos,
-            endPosition,
-            normalizedTime
-        )
     );
 }
 
-void updateSize(
-    Block &block,
-    const Vector2f &startSize,
-    const Vector2f &endSize,
-    const float normalizedTime
-) {
-    block.shape.setSize(
-        linearInterpolation(
-            startSize,
-            endSize,
-            normalizedTime
-        )
-    );
-}
-
-void updateAlpha(
-    Block &block,
-    const uint8_t &startA,
-    const uint8_t &endA,
-    const float normalizedTime
-) {
-    const auto currentA = static_cast<uint8_t>(
-        startA + normalizedTime * (static_cast<float>(endA) - static_cast<float>(startA))
-    );
-
-    Color currentColor = block.baseColor;
-    currentColor.a = currentA;
-    block.shape.setFillColor(currentColor);
-}
-
-void toNextStage(
-    Block &block,
-    const AnimationStage nextStage,
-    const float totalTime,
-    const float normalizedTime
-) {
-    if (normalizedTime >= ANIMATION_DURATION) {
-        block.stage = nextStage;
-        block.stageStartTime = totalTime;
-        block.stageStartPos = block.shape.getPosition();
-        block.stageStartSize = block.shape.getSize();
-    }
-}
-
-// Позиции
-Vector2f computeMoveRightTarget(
+BlockState sampleBlockState(
+    const BakedClip &clip,
     const Block &block,
-    const float shift = 200.f
-) {
-    Vector2f initial = getInitialPosition(block.index);
-    return {initial.x + shift, initial.y};
-}
-
-Vector2f computeGatherAtCenterTarget(
-    const Block &block
+    const float time
 ) {
-    const float totalHeight = (BLOCKS_COUNT - 1) * SPACING;
-    const float startY = WINDOW_CENTER.y - totalHeight * HALF_COMPENSATION_FACTOR;
-    float targetY = startY + static_cast<float>(block.index) * SPACING;
-    return {WINDOW_CENTER.x, targetY};
+    float values[CLIP_CHANNELS_PER_BLOCK];
+    sampleClip(clip, time + block.phase, block.index * CLIP_CHANNELS_PER_BLOCK, CLIP_CHANNELS_PER_BLOCK, values);
+    return {{values[0], values[1]}, {values[2], values[3]}, values[4]};
 }
 
-Vector2f computeSpreadHorizontalTarget(
-    const Block &block
+// Та же хореография сценарием: этапы идут подряд, без номера этапа
+Script blockScript(
+    [[maybe_unused]] ScriptContext &context, // кадр корутины и co_await берут его через promise
+    Actor &actor,
+    const size_t index
 ) {
-    const float totalWidth = (BLOCKS_COUNT - 1) * SPACING;
-    const float startX = WINDOW_CENTER.x - totalWidth / 2.f;
-    float targetX = startX + static_cast<float>(block.index) * SPACING;
-    return {targetX, WINDOW_CENTER.y};
+    const float offset = static_cast<float>(index) * SPACING;
+    constexpr float DURATION = ANIMATION_DURATION;
+    for (;;) {
+        co_await moveTo(actor, {INITIAL_POSITION.x + SHIFT, INITIAL_POSITION.y + offset}, DURATION);
+        co_await all(
+            moveTo(actor, {WINDOW_CENTER.x, WINDOW_CENTER.y - TOTAL_SPAN * HALF_COMPENSATION_FACTOR + offset}, DURATION),
+            fadeTo(actor, DIMMED_ALPHA, DURATION)
+        );
+        co_await moveTo(actor, {WINDOW_CENTER.x - TOTAL_SPAN / 2.f + offset, WINDOW_CENTER.y}, DURATION);
+        co_await all(
+            moveTo(actor, actor.position.to + Vector2f{0.f, -SHIFT}, DURATION),
+            resizeTo(actor, {BASE_SIZE.x, BASE_SIZE.y * HALF_COMPENSATION_FACTOR}, DURATION)
+        );
+        co_await moveTo(
+            actor,
+            {
+                WINDOW_CENTER.x - TOTAL_SPAN * HALF_COMPENSATION_FACTOR,
+                actor.position.to.y + static_cast<float>(index) * STACK_SPACING
+            },
+            DURATION
+        );
+        co_await all(
+            moveTo(actor, getInitialPosition(index), DURATION),
+            resizeTo(actor, BASE_SIZE, DURATION),
+            fadeTo(actor, FULL_ALPHA, DURATION)
+        );
+    }
 }
 
-Vector2f computeLiftUpTarget(
-    const Block &block,
-    const float shift = 200.f
+BlockState getActorState(
+    const Actor &actor,
+    const float time
 ) {
-    return {block.stageStartPos.x, block.stageStartPos.y - shift};
+    return {evaluateTween(actor.position, time), evaluateTween(actor.size, time), evaluateTween(actor.alpha, time)};
 }
 
-Vector2f computeVerticalStackTarget(
-    const Block &block
+void printSetterReport(
+    const vector<Block> &blocks
 ) {
-    constexpr float newHeight = BASE_SIDE * HALF_COMPENSATION_FACTOR;
-    constexpr float spacingY = newHeight + SPACING;
-    constexpr float totalWidth = (BLOCKS_COUNT - 1) * SPACING;
-    constexpr float firstBlockX = WINDOW_CENTER.x - totalWidth * HALF_COMPENSATION_FACTOR;
-    float targetY = block.stageStartPos.y + static_cast<float>(block.index) * spacingY;
-    return {firstBlockX, targetY};
+    SetterStats total;
+    for (const Block &block: blocks) {
+        addSetterStats(total, block.rect.stats);
+    }
+    printSetterReport(total);
 }
 
-Vector2f computeReturnToInitialTarget(
-    const Block &block
+void pollEvents(
+    RenderWindow &window
 ) {
-    return getInitialPosition(block.index);
-}
-
-// размер
-Vector2f computeLiftUpTargetSize() {
-    return {BASE_SIZE.x, BASE_SIZE.y * HALF_COMPENSATION_FACTOR};
-}
-
-Vector2f computeReturnToInitialSize() {
-    return BASE_SIZE;
-}
-
-// альфа
-uint8_t computeDimmedAlpha() {
-    return DEFAULT_COLOR.a / 2;
-}
-
-uint8_t computeFullAlpha() {
-    return DEFAULT_COLOR.a;
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = window.pollEvent()) {
+        if (event->is<Event::Closed>()) {
+            window.close();
+        }
+    }
 }
 
-void resetAnimation(
+void applyState(
     Block &block,
-    const float totalTime
+    const BlockState &state
 ) {
-    const Vector2f position = getInitialPosition(block.index);
-    block.shape.setPosition(position);
-    block.shape.setSize(BASE_SIZE);
-    block.shape.setFillColor(block.baseColor);
-
-    block.stage = AnimationStage::MoveRight;
-    block.stageStartPos = position;
-    block.stageStartSize = BASE_SIZE;
-    block.stageStartTime = totalTime;
+    setTrackedPosition(block.rect, state.position);
+    setTrackedSize(block.rect, state.size);
+
+    Color currentColor = block.baseColor;
+    currentColor.a = static_cast<uint8_t>(state.alpha);
+    setTrackedColor(block.rect, currentColor);
 }
 
+// Блоки играют запеченный клип, если он есть, иначе сценарии, если они
+// запущены, иначе свои дорожки
 void update(
     vector<Block> &blocks,
+    const BakedClip &clip,
+    ScriptContext &scripts,
     const Clock &clock
 ) {
+    PROFILE_ZONE("update");
     const float totalTime = clock.getElapsedTime().asSeconds();
+    const bool hasScripts = !scripts.scripts.empty();
+    if (hasScripts) {
+        updateScripts(scripts, totalTime);
+    }
 
     for (auto &block: blocks) {
-        // сценарий
-        switch (block.stage) {
-            case AnimationStage::MoveRight: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeMoveRightTarget(block);
-                updatePosition(block, endPos, t);
-                toNextStage(block, AnimationStage::MoveToWindowCenter, totalTime, t);
-                break;
-            }
-            case AnimationStage::MoveToWindowCenter: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeGatherAtCenterTarget(block);
-                uint8_t endA = computeDimmedAlpha();
-                updatePosition(block, endPos, t);
-                updateAlpha(block, block.baseColor.a, endA, t);
-                toNextStage(block, AnimationStage::MoveToHorizontal, totalTime, t);
-                break;
-            }
-            case AnimationStage::MoveToHorizontal: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeSpreadHorizontalTarget(block);
-                updatePosition(block, endPos, t);
-                toNextStage(block, AnimationStage::MoveTop, totalTime, t);
-                break;
-            }
-            case AnimationStage::MoveTop: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeLiftUpTarget(block);
-                Vector2f endSize = computeLiftUpTargetSize();
-                updatePosition(block, endPos, t);
-                updateSize(block, block.stageStartSize, endSize, t);
-                toNextStage(block, AnimationStage::MoveToVerticalStack, totalTime, t);
-                break;
-            }
-            case AnimationStage::MoveToVerticalStack: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeVerticalStackTarget(block);
-                updatePosition(block, endPos, t);
-                toNextStage(block, AnimationStage::MoveToInitialPosition, totalTime, t);
-                break;
-            }
-            case AnimationStage::MoveToInitialPosition: {
-                const float t = getNormalizedTime(block, totalTime);
-                Vector2f endPos = computeReturnToInitialTarget(block);
-                Vector2f endSize = computeReturnToInitialSize();
-                uint8_t endA = computeFullAlpha();
-                updatePosition(block, endPos, t);
-                updateSize(block, block.stageStartSize, endSize, t);
-                updateAlpha(block, block.baseColor.a / 2, endA, t);
-                toNextStage(block, AnimationStage::Finished, totalTime, t);
-                break;
-            }
-            case AnimationStage::Finished: {
-                resetAnimation(block, totalTime);
-                break;
-            }
+        if (clip.frameCount > 0) {
+            applyState(block, sampleBlockState(clip, block, totalTime));
+        } else if (hasScripts) {
+            applyState(block, getActorState(block.actor, totalTime));
+        } else {
+            applyState(block, evaluateTimeline(block.timeline, totalTime));
         }
     }
 }
@@ -305,14 +196,64 @@ void render(
     RenderWindow &window,
     const vector<Block> &blocks
 ) {
+    PROFILE_ZONE("render");
     window.clear(Color::White);
     for (const auto &block: blocks) {
-        window.draw(block.shape);
+        window.draw(block.rect.shape);
+    }
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
+}
+
+// --pipeline: анимация в своем потоке публикует копии блоков через тройной
+// буфер, главный поток рисует последнюю готовую копию
+void runPipelined(
+    RenderWindow &window,
+    vector<Block> &blocks,
+    const BakedClip &clip,
+    ScriptContext &scripts,
+    const Clock &clock,
+    FramePacer &framePacer
+) {
+    TripleBuffer<vector<Block>> snapshots;
+    atomic<bool> running{true};
+
+    thread simulationThread([&] {
+        Clock stepClock;
+        while (running.load(memory_order_relaxed)) {
+            stepClock.restart();
+            update(blocks, clip, scripts, clock);
+            // присваивание поэлементное: после первой копии без выделений памяти
+            snapshots.getBack() = blocks;
+            snapshots.publish();
+
+            const float untilNextStep = SIMULATION_STEP - stepClock.getElapsedTime().asSeconds();
+            if (untilNextStep > 0.f) {
+                sleep(seconds(untilNextStep));
+            }
+        }
+    });
+
+    while (window.isOpen()) {
+        PROFILE_ZONE("frame");
+        pollEvents(window);
+        snapshots.acquire();
+        render(window, snapshots.getFront());
+        waitNextFrame(framePacer);
     }
-    window.display();
+    printPacingReport(framePacer);
+
+    running = false;
+    simulationThread.join();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("complex_animation_01");
+
+    const vector<string> args(argv + 1, argv + argc);
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -329,15 +270,50 @@ int main() {
 
     vector<Block> blocks;
     blocks.reserve(BLOCKS_COUNT);
-    createBlock(blocks);
+    createBlock(blocks, createChoreography());
+
+    // --bake RATE: играть цикл из клипа, снятого RATE раз в секунду;
+    // --quantize хранит его в 16 битах, --phase-step S сдвигает i-й блок на i * S
+    BakedClip clip;
+    const float sampleRate = getFloatOption(args, "--bake", 0.f);
+    if (sampleRate > 0.f) {
+        const float phaseStep = getFloatOption(args, "--phase-step", 0.f);
+        for (Block &block: blocks) {
+            block.phase = static_cast<float>(block.index) * phaseStep;
+        }
+        const bool isQuantized = hasFlag(args, "--quantize");
+        bakeBlocks(clip, blocks, sampleRate, isQuantized);
+        printClipReport(clip);
+    }
 
+    // --script: блоки ведут сценарии-корутины
+    ScriptContext scripts;
     Clock clock;
+    if (hasFlag(args, "--script")) {
+        for (Block &block: blocks) {
+            startScript(scripts, blockScript(scripts, block.actor, block.index), 0.f);
+        }
+    }
+
+    FramePacer framePacer;
+    initFramePacer(framePacer, args);
+    if (hasFlag(args, "--pipeline")) {
+        runPipelined(window, blocks, clip, scripts, clock, framePacer);
+        printScriptReport(scripts);
+        printSetterReport(blocks);
+        return 0;
+    }
 
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window);
-        update(blocks, clock);
+        update(blocks, clip, scripts, clock);
         render(window, blocks);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
+    printScriptReport(scripts);
+    printSetterReport(blocks);
 
     return 0;
 }
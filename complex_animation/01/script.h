@@ -0,0 +1,436 @@
+// Сценарии анимации на корутинах C++20. Поведение блока пишется подряд:
+// co_await moveTo(...), затем co_await fadeTo(...), и сценарий стоит, пока
+// твин не закончился. Конец твина - таймер в колесе, и планировщик
+// возобновляет только те сценарии, чьи таймеры сработали: ждущий сценарий
+// за кадр ничего не стоит. Кадры корутин берутся из пула блоков по
+// классам размера, без обращения к куче на каждый сценарий
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../../common/timing_wheel.h"
+
+using namespace sf;
+using namespace std;
+
+// точность сроков твинов
+constexpr float SCRIPT_TICKS_PER_SECOND = 1000.f;
+
+constexpr size_t FRAME_SIZE_STEP = 64;
+constexpr size_t FRAME_SIZE_CLASSES = 16; // кадры до 1 КБ, больше - из кучи
+constexpr size_t FRAMES_PER_PAGE = 64;
+constexpr uint32_t NO_SIZE_CLASS = UINT32_MAX;
+
+// Перед каждым кадром: откуда он взят, чтобы вернуть его без контекста
+struct alignas(alignof(max_align_t)) FrameHeader {
+    struct FramePool *pool = nullptr;
+    uint32_t sizeClass = NO_SIZE_CLASS;
+};
+
+struct FramePool {
+    vector<unique_ptr<byte[]>> pages;
+    array<void *, FRAME_SIZE_CLASSES> freeLists{}; // следующий свободный - в самом блоке
+    array<byte *, FRAME_SIZE_CLASSES> freshNext{}; // еще не выданная часть последней страницы
+    array<size_t, FRAME_SIZE_CLASSES> freshLeft{};
+
+    uint64_t allocations = 0;
+    uint64_t fresh = 0; // выдано из только что нарезанных страниц
+    uint64_t reuses = 0; // выдано из возвращенных freeFrame
+    uint64_t fallbacks = 0; // не влезло ни в один класс
+};
+
+inline void *allocateFrame(
+    FramePool &pool,
+    const size_t size
+) {
+    ++pool.allocations;
+    const size_t total = sizeof(FrameHeader) + size;
+    const size_t sizeClass = (total + FRAME_SIZE_STEP - 1) / FRAME_SIZE_STEP - 1;
+
+    FrameHeader *header;
+    if (sizeClass >= FRAME_SIZE_CLASSES) {
+        ++pool.fallbacks;
+        header = static_cast<FrameHeader *>(::operator new(total));
+        header->sizeClass = NO_SIZE_CLASS;
+    } else {
+        // свободный список - только возвращенные блоки; новая страница
+        // нарезается по счетчику, без прохода по всем ее блокам
+        void *&freeList = pool.freeLists[sizeClass];
+        size_t &freshLeft = pool.freshLeft[sizeClass];
+        byte *&freshNext = pool.freshNext[sizeClass];
+        const size_t blockSize = (sizeClass + 1) * FRAME_SIZE_STEP;
+        void *block;
+        if (freeList) {
+            block = freeList;
+            freeList = *static_cast<void **>(block);
+            ++pool.reuses;
+        } else {
+            if (freshLeft == 0) {
+                pool.pages.push_back(make_unique<byte[]>(blockSize * FRAMES_PER_PAGE));
+                freshNext = pool.pages.back().get();
+                freshLeft = FRAMES_PER_PAGE;
+            }
+            block = freshNext;
+            freshNext += blockSize;
+            --freshLeft;
+            ++pool.fresh;
+        }
+        header = static_cast<FrameHeader *>(block);
+        header->sizeClass = static_cast<uint32_t>(sizeClass);
+    }
+    header->pool = &pool;
+    return header + 1;
+}
+
+inline void freeFrame(
+    void *frame
+) {
+    FrameHeader *header = static_cast<FrameHeader *>(frame) - 1;
+    if (header->sizeClass == NO_SIZE_CLASS) {
+        ::operator delete(header);
+        return;
+    }
+    void *&freeList = header->pool->freeLists[header->sizeClass];
+    *reinterpret_cast<void **>(header) = freeList;
+    freeList = header;
+}
+
+// Твин одного канала: from в момент startTime, to через duration
+template <typename T>
+struct Tween {
+    T from{};
+    T to{};
+    float startTime = 0;
+    float duration = 0;
+};
+
+template <typename T>
+T evaluateTween(
+    const Tween<T> &tween,
+    const float time
+) {
+    if (time >= tween.startTime + tween.duration) {
+        return tween.to;
+    }
+    if (time <= tween.startTime) {
+        return tween.from;
+    }
+    const float t = (time - tween.startTime) / tween.duration;
+    return tween.from + (tween.to - tween.from) * t;
+}
+
+// То, чем управляет сценарий: каналы блока
+struct Actor {
+    Tween<Vector2f> position;
+    Tween<Vector2f> size;
+    Tween<float> alpha;
+};
+
+enum class Channel {
+    Position,
+    Size,
+    Alpha
+};
+
+// Твин, который сценарий запускает через co_await
+struct TweenCommand {
+    Actor *actor = nullptr;
+    Channel channel = Channel::Position;
+    Vector2f target; // у прозрачности - только x
+    float duration = 0;
+};
+
+inline TweenCommand moveTo(
+    Actor &actor,
+    const Vector2f &position,
+    const float duration
+) {
+    return {&actor, Channel::Position, position, duration};
+}
+
+inline TweenCommand resizeTo(
+    Actor &actor,
+    const Vector2f &size,
+    const float duration
+) {
+    return {&actor, Channel::Size, size, duration};
+}
+
+inline TweenCommand fadeTo(
+    Actor &actor,
+    const float alpha,
+    const float duration
+) {
+    return {&actor, Channel::Alpha, {alpha, 0.f}, duration};
+}
+
+// Несколько твинов сразу: co_await all(moveTo(...), fadeTo(...)) ждет
+// самого длинного
+template <size_t N>
+struct TweenGroup {
+    array<TweenCommand, N> commands;
+};
+
+template <typename... Commands>
+TweenGroup<sizeof...(Commands)> all(
+    const Commands &... commands
+) {
+    return {{commands...}};
+}
+
+// Пауза без твинов
+struct Delay {
+    float duration = 0;
+};
+
+inline Delay wait(
+    const float duration
+) {
+    return {duration};
+}
+
+struct WaitingScript {
+    coroutine_handle<> handle;
+    float resumeTime = 0; // точный конец твина, с него начнется следующий
+};
+
+struct Script;
+
+// Общее для всех сценариев: время сценариев, таймеры концов твинов и
+// пул кадров. Пул объявлен первым, чтобы сценарии вернули в него кадры
+// до его разрушения
+struct ScriptContext {
+    FramePool pool;
+    vector<Script> scripts;
+
+    float now = 0; // время, от которого стартуют новые твины
+    TimingWheel timers; // данные таймера - номер в waiting
+    vector<WaitingScript> waiting;
+    vector<uint32_t> freeWaiting;
+    vector<uint32_t> fired; // сработавшие и уже прошедшие сроки, ждут updateScripts
+
+    uint64_t resumes = 0;
+};
+
+inline void startTween(
+    const TweenCommand &command,
+    const float now
+) {
+    Actor &actor = *command.actor;
+    switch (command.channel) {
+        case Channel::Position:
+            actor.position = {evaluateTween(actor.position, now), command.target, now, command.duration};
+            break;
+        case Channel::Size:
+            actor.size = {evaluateTween(actor.size, now), command.target, now, command.duration};
+            break;
+        case Channel::Alpha:
+            actor.alpha = {evaluateTween(actor.alpha, now), command.target.x, now, command.duration};
+            break;
+    }
+}
+
+// Усыпить сценарий до момента resumeTime
+inline void suspendUntil(
+    ScriptContext &context,
+    const coroutine_handle<> handle,
+    const float resumeTime
+) {
+    uint32_t id;
+    if (!context.freeWaiting.empty()) {
+        id = context.freeWaiting.back();
+        context.freeWaiting.pop_back();
+    } else {
+        id = static_cast<uint32_t>(context.waiting.size());
+        context.waiting.emplace_back();
+    }
+    context.waiting[id] = {handle, resumeTime};
+    const auto tick = static_cast<uint64_t>(ceil(resumeTime * SCRIPT_TICKS_PER_SECOND));
+    // колесо уже прошло этот тик: таймер сработал бы только на следующем
+    if (tick <= context.timers.now) {
+        context.fired.push_back(id);
+        return;
+    }
+    scheduleTimer(context.timers, tick, id);
+}
+
+// Запускает твины и засыпает до конца самого длинного; твины нулевой
+// длины применяются сразу, без засыпания
+template <size_t N>
+struct TweenAwaiter {
+    ScriptContext &context;
+    array<TweenCommand, N> commands;
+    float duration = 0;
+
+    bool await_ready() {
+        for (const TweenCommand &command: commands) {
+            startTween(command, context.now);
+            duration = max(duration, command.duration);
+        }
+        return duration <= 0.f;
+    }
+
+    void await_suspend(const coroutine_handle<> handle) {
+        suspendUntil(context, handle, context.now + duration);
+    }
+
+    void await_resume() {
+    }
+};
+
+struct DelayAwaiter {
+    ScriptContext &context;
+    float duration = 0;
+
+    bool await_ready() const {
+        return duration <= 0.f;
+    }
+
+    void await_suspend(const coroutine_handle<> handle) {
+        suspendUntil(context, handle, context.now + duration);
+    }
+
+    void await_resume() {
+    }
+};
+
+// Первый параметр корутины-сценария - ScriptContext &: через него
+// promise получает пул для кадра и контекст для co_await
+struct Script {
+    struct promise_type {
+        ScriptContext &context;
+
+        template <typename... Args>
+        explicit promise_type(
+            ScriptContext &context,
+            Args &...
+        ) : context(context) {
+        }
+
+        template <typename... Args>
+        static void *operator new(
+            const size_t size,
+            ScriptContext &context,
+            Args &...
+        ) {
+            return allocateFrame(context.pool, size);
+        }
+
+        static void operator delete(void *frame) {
+            freeFrame(frame);
+        }
+
+        Script get_return_object() {
+            return Script{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        // сценарий стартует из startScript, после конца ждет разрушения
+        suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            terminate();
+        }
+
+        TweenAwaiter<1> await_transform(const TweenCommand &command) {
+            return {context, {command}};
+        }
+
+        template <size_t N>
+        TweenAwaiter<N> await_transform(const TweenGroup<N> &group) {
+            return {context, group.commands};
+        }
+
+        DelayAwaiter await_transform(const Delay &delay) {
+            return {context, delay.duration};
+        }
+    };
+
+    coroutine_handle<promise_type> handle;
+
+    explicit Script(const coroutine_handle<promise_type> handle) : handle(handle) {
+    }
+
+    Script(Script &&other) noexcept : handle(exchange(other.handle, {})) {
+    }
+
+    Script &operator=(Script &&other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    Script(const Script &) = delete;
+    Script &operator=(const Script &) = delete;
+
+    ~Script() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+};
+
+// Запустить сценарий в момент time: он идет до первого co_await
+inline void startScript(
+    ScriptContext &context,
+    Script script,
+    const float time
+) {
+    context.now = time;
+    context.scripts.push_back(move(script));
+    context.scripts.back().handle.resume();
+}
+
+// Возобновить сценарии, чьи твины закончились к моменту time. Каждый
+// продолжает с точного конца своего твина, поэтому следующие твины
+// не отстают на остаток кадра. Если и следующий твин уже закончился
+// (после долгого кадра), сценарий возобновляется снова в этом же вызове,
+// пока сроков до time не останется
+inline void updateScripts(
+    ScriptContext &context,
+    const float time
+) {
+    advanceTimingWheel(context.timers, static_cast<uint64_t>(time * SCRIPT_TICKS_PER_SECOND), context.fired);
+    // по индексу: suspendUntil дописывает в fired уже прошедшие сроки
+    for (size_t i = 0; i < context.fired.size(); ++i) {
+        const uint32_t id = context.fired[i];
+        const WaitingScript waiting = context.waiting[id];
+        context.freeWaiting.push_back(id);
+        context.now = waiting.resumeTime;
+        waiting.handle.resume();
+        ++context.resumes;
+    }
+    context.fired.clear();
+}
+
+inline void printScriptReport(
+    const ScriptContext &context
+) {
+    const FramePool &pool = context.pool;
+    cout << "scripts: " << context.scripts.size() << ", resumed " << context.resumes
+        << ", frames allocated " << pool.allocations << " (" << pool.fresh << " fresh, " << pool.reuses << " reused, "
+        << pool.fallbacks << " from heap, " << pool.pages.size() << " pages)" << endl;
+}
@@ -0,0 +1,174 @@
+// Анимация блоков как данные. Хореография - список этапов, у каждого этапа
+// своя длительность и правила целей для позиции, размера и прозрачности.
+// Цели разрешаются один раз, при построении дорожек ключевых кадров блока,
+// а кадр анимации - это поиск ключа по курсору и линейная интерполяция
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+using namespace sf;
+using namespace std;
+
+// Ключи по возрастанию времени. Курсор - ключ, найденный прошлым поиском:
+// время обычно идет вперед, и следующий ключ ищется от него за O(1)
+template <typename T>
+struct Track {
+    vector<float> times;
+    vector<T> values;
+    size_t cursor = 0;
+};
+
+template <typename T>
+void addKey(
+    Track<T> &track,
+    const float time,
+    const T &value
+) {
+    track.times.push_back(time);
+    track.values.push_back(value);
+}
+
+// Значение дорожки в момент time: до первого ключа и после последнего
+// держится крайнее значение, между ключами - линейная интерполяция
+template <typename T>
+T evaluateTrack(
+    Track<T> &track,
+    const float time
+) {
+    const vector<float> &times = track.times;
+    if (time <= times.front()) {
+        return track.values.front();
+    }
+    if (time >= times.back()) {
+        return track.values.back();
+    }
+
+    size_t &key = track.cursor;
+    if (key + 1 >= times.size() || time < times[key]) {
+        // время пошло назад или по кругу: двоичный поиск
+        key = static_cast<size_t>(upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+    } else {
+        while (time >= times[key + 1]) {
+            ++key;
+        }
+    }
+    const float t = (time - times[key]) / (times[key + 1] - times[key]);
+    return track.values[key] + (track.values[key + 1] - track.values[key]) * t;
+}
+
+// От чего отсчитывается цель этапа по одной оси
+enum class Anchor {
+    Absolute, // base + index * perIndex
+    StageStart // значение в начале этапа + base + index * perIndex
+};
+
+struct AxisRule {
+    Anchor anchor = Anchor::Absolute;
+    float base = 0;
+    float perIndex = 0;
+};
+
+struct PointRule {
+    AxisRule x;
+    AxisRule y;
+};
+
+inline float resolveRule(
+    const AxisRule &rule,
+    const size_t index,
+    const float startValue
+) {
+    const float offset = rule.base + static_cast<float>(index) * rule.perIndex;
+    return rule.anchor == Anchor::StageStart ? startValue + offset : offset;
+}
+
+inline Vector2f resolveRule(
+    const PointRule &rule,
+    const size_t index,
+    const Vector2f &startValue
+) {
+    return {resolveRule(rule.x, index, startValue.x), resolveRule(rule.y, index, startValue.y)};
+}
+
+// Этап хореографии: канал без правила на этом этапе не меняется
+struct StageSpec {
+    float duration = 1.f;
+    optional<PointRule> position;
+    optional<PointRule> size;
+    optional<AxisRule> alpha;
+};
+
+struct BlockState {
+    Vector2f position;
+    Vector2f size;
+    float alpha = 0;
+};
+
+struct BlockTimeline {
+    Track<Vector2f> position;
+    Track<Vector2f> size;
+    Track<float> alpha;
+    float duration = 0; // длина цикла, дальше анимация повторяется
+};
+
+// Ключи одного канала за этап: значение в начале (если канал перед этим
+// стоял) и разрешенная цель в конце
+template <typename T, typename Rule>
+void appendStageKeys(
+    Track<T> &track,
+    T &current,
+    const optional<Rule> &rule,
+    const size_t index,
+    const float start,
+    const float end
+) {
+    if (!rule) {
+        return;
+    }
+    if (track.times.back() < start) {
+        addKey(track, start, current);
+    }
+    current = resolveRule(*rule, index, current);
+    addKey(track, end, current);
+}
+
+// Дорожки блока с номером index для всего цикла хореографии
+inline BlockTimeline buildTimeline(
+    const vector<StageSpec> &choreography,
+    const size_t index,
+    const BlockState &initial
+) {
+    BlockTimeline timeline;
+    BlockState current = initial;
+    addKey(timeline.position, 0.f, current.position);
+    addKey(timeline.size, 0.f, current.size);
+    addKey(timeline.alpha, 0.f, current.alpha);
+
+    float start = 0.f;
+    for (const StageSpec &stage: choreography) {
+        const float end = start + stage.duration;
+        appendStageKeys(timeline.position, current.position, stage.position, index, start, end);
+        appendStageKeys(timeline.size, current.size, stage.size, index, start, end);
+        appendStageKeys(timeline.alpha, current.alpha, stage.alpha, index, start, end);
+        start = end;
+    }
+    timeline.duration = start;
+    return timeline;
+}
+
+// Состояние блока в момент time от начала анимации
+inline BlockState evaluateTimeline(
+    BlockTimeline &timeline,
+    const float time
+) {
+    const float cycleTime = timeline.duration > 0.f ? fmod(time, timeline.duration) : 0.f;
+    return {
+        evaluateTrack(timeline.position, cycleTime),
+        evaluateTrack(timeline.size, cycleTime),
+        evaluateTrack(timeline.alpha, cycleTime)
+    };
+}
@@ -0,0 +1,126 @@
+// Прямоугольник с отслеживанием изменений. Сеттеры RectangleShape
+// пересчитывают точки или цвета вершин даже при том же значении; здесь
+// каждое свойство помнит последнее примененное значение, и повтор
+// пропускается. Новый размер без контура ставится масштабом поверх
+// точек, построенных один раз, а не пересборкой фигуры. Пропуски
+// считаются, чтобы экономию было видно
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <iostream>
+
+using namespace sf;
+using namespace std;
+
+struct SetterStats {
+    uint64_t positionSets = 0;
+    uint64_t positionSkips = 0;
+    uint64_t scaleSets = 0; // размер через масштаб, без пересборки точек
+    uint64_t resizes = 0; // размер через setSize
+    uint64_t sizeSkips = 0;
+    uint64_t colorSets = 0;
+    uint64_t colorSkips = 0;
+};
+
+struct TrackedRect {
+    RectangleShape shape;
+    Vector2f geometrySize; // размер, под который построены точки
+    Vector2f origin; // точка привязки в координатах размера geometrySize
+    Vector2f size;
+    SetterStats stats;
+};
+
+inline void initTrackedRect(
+    TrackedRect &rect,
+    const Vector2f &size,
+    const Vector2f &origin,
+    const Vector2f &position,
+    const Color &color
+) {
+    rect.shape.setSize(size);
+    rect.shape.setOrigin(origin);
+    rect.shape.setPosition(position);
+    rect.shape.setFillColor(color);
+    rect.geometrySize = size;
+    rect.origin = origin;
+    rect.size = size;
+}
+
+inline void setTrackedPosition(
+    TrackedRect &rect,
+    const Vector2f &position
+) {
+    if (rect.shape.getPosition() == position) {
+        ++rect.stats.positionSkips;
+        return;
+    }
+    rect.shape.setPosition(position);
+    ++rect.stats.positionSets;
+}
+
+// Масштаб растягивает и контур, поэтому с контуром или при вырожденных
+// точках размер ставится честно. Точка привязки делится на масштаб:
+// тогда угол прямоугольника остается там же, где его поставил бы setSize
+inline void setTrackedSize(
+    TrackedRect &rect,
+    const Vector2f &size
+) {
+    if (rect.size == size) {
+        ++rect.stats.sizeSkips;
+        return;
+    }
+    rect.size = size;
+
+    const bool canScale = rect.shape.getOutlineThickness() == 0.f
+        && rect.geometrySize.x != 0.f && rect.geometrySize.y != 0.f
+        && size.x != 0.f && size.y != 0.f;
+    if (!canScale) {
+        rect.shape.setScale({1.f, 1.f});
+        rect.shape.setOrigin(rect.origin);
+        rect.shape.setSize(size);
+        rect.geometrySize = size;
+        ++rect.stats.resizes;
+        return;
+    }
+    const Vector2f scale = {size.x / rect.geometrySize.x, size.y / rect.geometrySize.y};
+    rect.shape.setScale(scale);
+    rect.shape.setOrigin({rect.origin.x / scale.x, rect.origin.y / scale.y});
+    ++rect.stats.scaleSets;
+}
+
+inline void setTrackedColor(
+    TrackedRect &rect,
+    const Color &color
+) {
+    if (rect.shape.getFillColor() == color) {
+        ++rect.stats.colorSkips;
+        return;
+    }
+    rect.shape.setFillColor(color);
+    ++rect.stats.colorSets;
+}
+
+inline void addSetterStats(
+    SetterStats &total,
+    const SetterStats &stats
+) {
+    total.positionSets += stats.positionSets;
+    total.positionSkips += stats.positionSkips;
+    total.scaleSets += stats.scaleSets;
+    total.resizes += stats.resizes;
+    total.sizeSkips += stats.sizeSkips;
+    total.colorSets += stats.colorSets;
+    total.colorSkips += stats.colorSkips;
+}
+
+inline void printSetterReport(
+    const SetterStats &stats
+) {
+    const uint64_t skips = stats.positionSkips + stats.sizeSkips + stats.colorSkips;
+    const uint64_t sets = stats.positionSets + stats.scaleSets + stats.resizes + stats.colorSets;
+    cout << "setters: " << sets << " applied, " << skips << " elided"
+        << " (position " << stats.positionSkips << ", size " << stats.sizeSkips
+        << ", color " << stats.colorSkips << "); sizes as scale " << stats.scaleSets
+        << ", rebuilt " << stats.resizes << endl;
+}
@@ -0,0 +1,425 @@
+// Твины блоков в плоских массивах. Начало и конец текущего этапа, момент
+// его начала и обратная длительность хранятся по каналам, а не в фигурах:
+// все блоки считаются одним проходом векторными lerp, и результат сразу
+// пишется вершинами в общий буфер кадра. Смены этапов стоят таймерами
+// в колесе: за кадр трогаются только блоки, чей этап закончился, и цели
+// нового этапа разрешаются по той же хореографии, что и у 01
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define TWEENS_HAVE_SSE2 1
+#if defined(__GNUC__)
+#define TWEENS_HAVE_AVX2 1
+#endif
+#endif
+
+#include "../../common/timing_wheel.h"
+#include "../01/timeline.h"
+
+using namespace sf;
+using namespace std;
+
+// блоков в пачке: промежуточные результаты пачки помещаются в L1
+constexpr size_t TWEEN_CHUNK = 256;
+// прямоугольник - два треугольника
+constexpr size_t VERTICES_PER_BLOCK = 6;
+// точность сроков смены этапов
+constexpr float TRANSITION_TICKS_PER_SECOND = 1000.f;
+
+// Значения каналов - в координатах хореографии; на экран блок попадает
+// через offset и общий scale
+struct BlockTweens {
+    vector<float> startX;
+    vector<float> startY;
+    vector<float> endX;
+    vector<float> endY;
+    vector<float> startWidth;
+    vector<float> startHeight;
+    vector<float> endWidth;
+    vector<float> endHeight;
+    vector<float> startAlpha;
+    vector<float> endAlpha;
+    vector<float> startTime;
+    vector<float> inverseDuration;
+    vector<float> offsetX;
+    vector<float> offsetY;
+    vector<uint32_t> stage;
+    vector<uint32_t> choreographyIndex; // номер блока для правил этапов
+    TimingWheel transitions; // конец текущего этапа каждого блока
+
+    float scale = 1.f;
+    Vector2f origin; // точка блока, которая ставится в позицию, как setOrigin
+    Color color;
+};
+
+// Результат пачки: прямоугольник на экране и прозрачность
+struct TweenChunk {
+    alignas(32) float left[TWEEN_CHUNK];
+    alignas(32) float top[TWEEN_CHUNK];
+    alignas(32) float right[TWEEN_CHUNK];
+    alignas(32) float bottom[TWEEN_CHUNK];
+    alignas(32) float alpha[TWEEN_CHUNK];
+};
+
+inline size_t getBlocksCount(
+    const BlockTweens &tweens
+) {
+    return tweens.stage.size();
+}
+
+inline uint64_t getTransitionTick(
+    const float time
+) {
+    return static_cast<uint64_t>(ceil(time * TRANSITION_TICKS_PER_SECOND));
+}
+
+// Таймер на конец текущего этапа блока
+inline void scheduleTransition(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const size_t i
+) {
+    const float endTime = tweens.startTime[i] + choreography[tweens.stage[i]].duration;
+    scheduleTimer(tweens.transitions, getTransitionTick(endTime), static_cast<uint32_t>(i));
+}
+
+// Начать этап stage с момента startTime: начало твина - конец прошлого
+// этапа, конец - цели этапа; канал без правила стоит на месте
+inline void startStage(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const size_t i,
+    const uint32_t stage,
+    const float startTime
+) {
+    const StageSpec &spec = choreography[stage];
+    const size_t index = tweens.choreographyIndex[i];
+
+    const Vector2f position = {tweens.endX[i], tweens.endY[i]};
+    const Vector2f size = {tweens.endWidth[i], tweens.endHeight[i]};
+    const float alpha = tweens.endAlpha[i];
+    const Vector2f endPosition = spec.position ? resolveRule(*spec.position, index, position) : position;
+    const Vector2f endSize = spec.size ? resolveRule(*spec.size, index, size) : size;
+
+    tweens.startX[i] = position.x;
+    tweens.startY[i] = position.y;
+    tweens.endX[i] = endPosition.x;
+    tweens.endY[i] = endPosition.y;
+    tweens.startWidth[i] = size.x;
+    tweens.startHeight[i] = size.y;
+    tweens.endWidth[i] = endSize.x;
+    tweens.endHeight[i] = endSize.y;
+    tweens.startAlpha[i] = alpha;
+    tweens.endAlpha[i] = spec.alpha ? resolveRule(*spec.alpha, index, alpha) : alpha;
+    tweens.startTime[i] = startTime;
+    tweens.inverseDuration[i] = 1.f / spec.duration;
+    tweens.stage[i] = stage;
+}
+
+// Добавить блок в начале первого этапа хореографии
+inline void addBlock(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const size_t choreographyIndex,
+    const Vector2f &offset,
+    const BlockState &initial
+) {
+    const size_t i = getBlocksCount(tweens);
+    for (vector<float> *channel: {
+             &tweens.startX, &tweens.startY, &tweens.endX, &tweens.endY,
+             &tweens.startWidth, &tweens.startHeight, &tweens.endWidth, &tweens.endHeight,
+             &tweens.startAlpha, &tweens.endAlpha, &tweens.startTime, &tweens.inverseDuration
+         }) {
+        channel->push_back(0.f);
+    }
+    tweens.offsetX.push_back(offset.x);
+    tweens.offsetY.push_back(offset.y);
+    tweens.stage.push_back(0);
+    tweens.choreographyIndex.push_back(static_cast<uint32_t>(choreographyIndex));
+
+    tweens.endX[i] = initial.position.x;
+    tweens.endY[i] = initial.position.y;
+    tweens.endWidth[i] = initial.size.x;
+    tweens.endHeight[i] = initial.size.y;
+    tweens.endAlpha[i] = initial.alpha;
+    startStage(tweens, choreography, i, 0, 0.f);
+    scheduleTransition(tweens, choreography, i);
+}
+
+// Набор инструкций для прохода по твинам
+enum class TweenKernel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+inline const char *toString(const TweenKernel kernel) {
+    switch (kernel) {
+        case TweenKernel::Sse2:
+            return "sse2";
+        case TweenKernel::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+inline TweenKernel detectTweenKernel() {
+#if TWEENS_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return TweenKernel::Avx2;
+    }
+#endif
+#if TWEENS_HAVE_SSE2
+    return TweenKernel::Sse2;
+#else
+    return TweenKernel::Scalar;
+#endif
+}
+
+inline vector<TweenKernel> getSupportedTweenKernels() {
+    vector<TweenKernel> kernels = {TweenKernel::Scalar};
+    const TweenKernel best = detectTweenKernel();
+    if (best == TweenKernel::Sse2 || best == TweenKernel::Avx2) {
+        kernels.push_back(TweenKernel::Sse2);
+    }
+    if (best == TweenKernel::Avx2) {
+        kernels.push_back(TweenKernel::Avx2);
+    }
+    return kernels;
+}
+
+// Блоки [begin, end) пачки, которая начинается с блока base. Векторные
+// версии повторяют эти операции в том же порядке, поэтому результат
+// совпадает побитно
+inline void evaluateTweensScalar(
+    const BlockTweens &tweens,
+    const size_t base,
+    const size_t begin,
+    const size_t end,
+    const float time,
+    TweenChunk &chunk
+) {
+    for (size_t i = begin; i < end; ++i) {
+        const size_t k = i - base;
+        const float phase = (time - tweens.startTime[i]) * tweens.inverseDuration[i];
+        const float t = min(max(phase, 0.f), 1.f);
+        const float x = tweens.startX[i] + (tweens.endX[i] - tweens.startX[i]) * t;
+        const float y = tweens.startY[i] + (tweens.endY[i] - tweens.startY[i]) * t;
+        const float width = tweens.startWidth[i] + (tweens.endWidth[i] - tweens.startWidth[i]) * t;
+        const float height = tweens.startHeight[i] + (tweens.endHeight[i] - tweens.startHeight[i]) * t;
+
+        chunk.left[k] = tweens.offsetX[i] + (x - tweens.origin.x) * tweens.scale;
+        chunk.top[k] = tweens.offsetY[i] + (y - tweens.origin.y) * tweens.scale;
+        chunk.right[k] = chunk.left[k] + width * tweens.scale;
+        chunk.bottom[k] = chunk.top[k] + height * tweens.scale;
+        chunk.alpha[k] = tweens.startAlpha[i] + (tweens.endAlpha[i] - tweens.startAlpha[i]) * t;
+    }
+}
+
+#if TWEENS_HAVE_SSE2
+// a + (b - a) * t
+inline __m128 lerpSse2(
+    const float *a,
+    const float *b,
+    const __m128 t
+) {
+    const __m128 start = _mm_loadu_ps(a);
+    return _mm_add_ps(start, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b), start), t));
+}
+
+// Возвращает, сколько блоков посчитано; остаток - скалярно
+inline size_t evaluateTweensSse2(
+    const BlockTweens &tweens,
+    const size_t begin,
+    const size_t end,
+    const float time,
+    TweenChunk &chunk
+) {
+    constexpr size_t LANES = 4;
+    const __m128 now = _mm_set1_ps(time);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 scale = _mm_set1_ps(tweens.scale);
+    const __m128 originX = _mm_set1_ps(tweens.origin.x);
+    const __m128 originY = _mm_set1_ps(tweens.origin.y);
+
+    size_t i = begin;
+    for (; i + LANES <= end; i += LANES) {
+        const size_t k = i - begin;
+        const __m128 phase = _mm_mul_ps(
+            _mm_sub_ps(now, _mm_loadu_ps(&tweens.startTime[i])), _mm_loadu_ps(&tweens.inverseDuration[i]));
+        const __m128 t = _mm_min_ps(_mm_max_ps(phase, zero), one);
+        const __m128 x = lerpSse2(&tweens.startX[i], &tweens.endX[i], t);
+        const __m128 y = lerpSse2(&tweens.startY[i], &tweens.endY[i], t);
+        const __m128 width = lerpSse2(&tweens.startWidth[i], &tweens.endWidth[i], t);
+        const __m128 height = lerpSse2(&tweens.startHeight[i], &tweens.endHeight[i], t);
+
+        const __m128 left = _mm_add_ps(_mm_loadu_ps(&tweens.offsetX[i]), _mm_mul_ps(_mm_sub_ps(x, originX), scale));
+        const __m128 top = _mm_add_ps(_mm_loadu_ps(&tweens.offsetY[i]), _mm_mul_ps(_mm_sub_ps(y, originY), scale));
+        _mm_store_ps(&chunk.left[k], left);
+        _mm_store_ps(&chunk.top[k], top);
+        _mm_store_ps(&chunk.right[k], _mm_add_ps(left, _mm_mul_ps(width, scale)));
+        _mm_store_ps(&chunk.bottom[k], _mm_add_ps(top, _mm_mul_ps(height, scale)));
+        _mm_store_ps(&chunk.alpha[k], lerpSse2(&tweens.startAlpha[i], &tweens.endAlpha[i], t));
+    }
+    return i;
+}
+#endif
+
+#if TWEENS_HAVE_AVX2
+__attribute__((target("avx2")))
+inline __m256 lerpAvx2(
+    const float *a,
+    const float *b,
+    const __m256 t
+) {
+    const __m256 start = _mm256_loadu_ps(a);
+    return _mm256_add_ps(start, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b), start), t));
+}
+
+__attribute__((target("avx2")))
+inline size_t evaluateTweensAvx2(
+    const BlockTweens &tweens,
+    const size_t begin,
+    const size_t end,
+    const float time,
+    TweenChunk &chunk
+) {
+    constexpr size_t LANES = 8;
+    const __m256 now = _mm256_set1_ps(time);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 scale = _mm256_set1_ps(tweens.scale);
+    const __m256 originX = _mm256_set1_ps(tweens.origin.x);
+    const __m256 originY = _mm256_set1_ps(tweens.origin.y);
+
+    size_t i = begin;
+    for (; i + LANES <= end; i += LANES) {
+        const size_t k = i - begin;
+        const __m256 phase = _mm256_mul_ps(
+            _mm256_sub_ps(now, _mm256_loadu_ps(&tweens.startTime[i])), _mm256_loadu_ps(&tweens.inverseDuration[i]));
+        const __m256 t = _mm256_min_ps(_mm256_max_ps(phase, zero), one);
+        const __m256 x = lerpAvx2(&tweens.startX[i], &tweens.endX[i], t);
+        const __m256 y = lerpAvx2(&tweens.startY[i], &tweens.endY[i], t);
+        const __m256 width = lerpAvx2(&tweens.startWidth[i], &tweens.endWidth[i], t);
+        const __m256 height = lerpAvx2(&tweens.startHeight[i], &tweens.endHeight[i], t);
+
+        const __m256 left = _mm256_add_ps(
+            _mm256_loadu_ps(&tweens.offsetX[i]), _mm256_mul_ps(_mm256_sub_ps(x, originX), scale));
+        const __m256 top = _mm256_add_ps(
+            _mm256_loadu_ps(&tweens.offsetY[i]), _mm256_mul_ps(_mm256_sub_ps(y, originY), scale));
+        _mm256_store_ps(&chunk.left[k], left);
+        _mm256_store_ps(&chunk.top[k], top);
+        _mm256_store_ps(&chunk.right[k], _mm256_add_ps(left, _mm256_mul_ps(width, scale)));
+        _mm256_store_ps(&chunk.bottom[k], _mm256_add_ps(top, _mm256_mul_ps(height, scale)));
+        _mm256_store_ps(&chunk.alpha[k], lerpAvx2(&tweens.startAlpha[i], &tweens.endAlpha[i], t));
+    }
+    return i;
+}
+#endif
+
+// Вершины блоков пачки: прямоугольник двумя треугольниками
+inline void writeChunkVertices(
+    const TweenChunk &chunk,
+    const size_t begin,
+    const size_t count,
+    const Color &baseColor,
+    Vertex *vertices
+) {
+    for (size_t k = 0; k < count; ++k) {
+        Color color = baseColor;
+        color.a = static_cast<uint8_t>(chunk.alpha[k]);
+        const Vector2f topLeft = {chunk.left[k], chunk.top[k]};
+        const Vector2f topRight = {chunk.right[k], chunk.top[k]};
+        const Vector2f bottomLeft = {chunk.left[k], chunk.bottom[k]};
+        const Vector2f bottomRight = {chunk.right[k], chunk.bottom[k]};
+
+        Vertex *quad = vertices + (begin + k) * VERTICES_PER_BLOCK;
+        quad[0] = Vertex{topLeft, color};
+        quad[1] = Vertex{topRight, color};
+        quad[2] = Vertex{bottomLeft, color};
+        quad[3] = Vertex{bottomLeft, color};
+        quad[4] = Vertex{topRight, color};
+        quad[5] = Vertex{bottomRight, color};
+    }
+}
+
+// Посчитать блоки [begin, end) и записать их вершины
+inline void evaluateTweenRange(
+    const BlockTweens &tweens,
+    const size_t begin,
+    const size_t end,
+    const float time,
+    const TweenKernel kernel,
+    TweenChunk &chunk,
+    vector<Vertex> &vertices
+) {
+    size_t done = begin;
+    switch (kernel) {
+#if TWEENS_HAVE_AVX2
+        case TweenKernel::Avx2:
+            done = evaluateTweensAvx2(tweens, begin, end, time, chunk);
+            break;
+#endif
+#if TWEENS_HAVE_SSE2
+        case TweenKernel::Sse2:
+            done = evaluateTweensSse2(tweens, begin, end, time, chunk);
+            break;
+#endif
+        default:
+            break;
+    }
+    evaluateTweensScalar(tweens, begin, done, end, time, chunk);
+
+    writeChunkVertices(chunk, begin, end - begin, tweens.color, vertices.data());
+}
+
+// Перевести на следующий этап блоки, чьи таймеры сработали к моменту
+// time. Новый этап начинается ровно в конце прошлого, поэтому времена
+// не плывут; после долгого кадра блок может пройти несколько этапов сразу
+inline void fireTransitions(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const float time,
+    vector<uint32_t> &fired
+) {
+    fired.clear();
+    advanceTimingWheel(
+        tweens.transitions, static_cast<uint64_t>(time * TRANSITION_TICKS_PER_SECOND), fired);
+    for (const uint32_t i: fired) {
+        do {
+            const uint32_t stage = tweens.stage[i];
+            const uint32_t next = (stage + 1) % static_cast<uint32_t>(choreography.size());
+            startStage(tweens, choreography, i, next, tweens.startTime[i] + choreography[stage].duration);
+        } while ((time - tweens.startTime[i]) * tweens.inverseDuration[i] >= 1.f);
+        scheduleTransition(tweens, choreography, i);
+    }
+}
+
+// Кадр анимации: смены этапов по таймерам, затем все блоки одним
+// проходом пачками по TWEEN_CHUNK
+inline void updateTweens(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const float time,
+    const TweenKernel kernel,
+    TweenChunk &chunk,
+    vector<Vertex> &vertices,
+    vector<uint32_t> &fired
+) {
+    fireTransitions(tweens, choreography, time, fired);
+
+    const size_t count = getBlocksCount(tweens);
+    vertices.resize(count * VERTICES_PER_BLOCK);
+    for (size_t begin = 0; begin < count; begin += TWEEN_CHUNK) {
+        evaluateTweenRange(tweens, begin, min(begin + TWEEN_CHUNK, count), time, kernel, chunk, vertices);
+    }
+}
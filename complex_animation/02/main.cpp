@@ -0,0 +1,314 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../common/command_line.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../01/choreography.h"
+#include "block_tweens.h"
+
+using namespace sf;
+using namespace std;
+
+constexpr size_t DEFAULT_BLOCKS = 100000;
+
+// Блоки идут группами по BLOCKS_COUNT: каждая группа - уменьшенная копия
+// сцены 01 в своей клетке сетки на всё окно
+void initBlockTweens(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const size_t blocksCount
+) {
+    const size_t groupsCount = (blocksCount + BLOCKS_COUNT - 1) / BLOCKS_COUNT;
+    const auto columns = static_cast<size_t>(ceil(sqrt(static_cast<float>(groupsCount))));
+    const size_t rows = (groupsCount + columns - 1) / columns;
+    const Vector2f cell = {
+        static_cast<float>(WINDOW_WIDTH) / static_cast<float>(columns),
+        static_cast<float>(WINDOW_HEIGHT) / static_cast<float>(rows)
+    };
+
+    tweens.scale = cell.x / static_cast<float>(WINDOW_WIDTH);
+    tweens.origin = BASE_SIZE / 2.f;
+    tweens.color = DEFAULT_COLOR;
+    for (size_t i = 0; i < blocksCount; ++i) {
+        const size_t group = i / BLOCKS_COUNT;
+        const size_t index = i % BLOCKS_COUNT;
+        const Vector2f offset = {
+            static_cast<float>(group % columns) * cell.x,
+            static_cast<float>(group / columns) * cell.y
+        };
+        const BlockState initial = {getInitialPosition(index), BASE_SIZE, static_cast<float>(DEFAULT_COLOR.a)};
+        addBlock(tweens, choreography, index, offset, initial);
+    }
+}
+
+// Все ядра должны давать одинаковые вершины на одном и том же отрезке
+// анимации, включая смены этапов; false - какое-то ядро разошлось со скалярным
+bool verifyTweenKernels() {
+    constexpr size_t BLOCKS = 10007;
+    constexpr int STEPS = 600;
+    const vector<StageSpec> choreography = createChoreography();
+
+    BlockTweens reference;
+    initBlockTweens(reference, choreography, BLOCKS);
+    TweenChunk chunk;
+    vector<Vertex> referenceVertices;
+    vector<uint32_t> fired;
+
+    bool allSame = true;
+    for (const TweenKernel kernel: getSupportedTweenKernels()) {
+        BlockTweens expected = reference;
+        BlockTweens actual = reference;
+        vector<Vertex> vertices;
+        size_t mismatches = 0;
+        for (int step = 1; step <= STEPS; ++step) {
+            const float time = static_cast<float>(step) / 60.f;
+            updateTweens(expected, choreography, time, TweenKernel::Scalar, chunk, referenceVertices, fired);
+            updateTweens(actual, choreography, time, kernel, chunk, vertices, fired);
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                if (vertices[i].position != referenceVertices[i].position
+                    || vertices[i].color != referenceVertices[i].color) {
+                    ++mismatches;
+                }
+            }
+        }
+        cout << toString(kernel) << ": " << mismatches << " mismatched vertices" << endl;
+        allSame = allSame && mismatches == 0;
+    }
+    return allSame;
+}
+
+void benchmarkTweenKernels(
+    const size_t blocksCount
+) {
+    constexpr int STEPS = 200;
+    const vector<StageSpec> choreography = createChoreography();
+
+    BlockTweens initial;
+    initBlockTweens(initial, choreography, blocksCount);
+    TweenChunk chunk;
+    vector<Vertex> vertices;
+    vector<uint32_t> fired;
+
+    for (const TweenKernel kernel: getSupportedTweenKernels()) {
+        BlockTweens tweens = initial;
+        Clock timer;
+        for (int step = 0; step < STEPS; ++step) {
+            updateTweens(tweens, choreography, static_cast<float>(step) / 60.f, kernel, chunk, vertices, fired);
+        }
+        const float elapsed = timer.getElapsedTime().asSeconds();
+        const double blocksPerSecond = static_cast<double>(blocksCount) * STEPS / elapsed;
+        cout << toString(kernel) << ": " << blocksPerSecond / 1e6 << " M blocks/s" << endl;
+    }
+}
+
+// Смены этапов прежним способом: проверка конца этапа у каждого блока
+size_t scanTransitions(
+    BlockTweens &tweens,
+    const vector<StageSpec> &choreography,
+    const float time
+) {
+    size_t transitions = 0;
+    for (size_t i = 0; i < getBlocksCount(tweens); ++i) {
+        while ((time - tweens.startTime[i]) * tweens.inverseDuration[i] >= 1.f) {
+            const uint32_t stage = tweens.stage[i];
+            const uint32_t next = (stage + 1) % static_cast<uint32_t>(choreography.size());
+            startStage(tweens, choreography, i, next, tweens.startTime[i] + choreography[stage].duration);
+            ++transitions;
+        }
+    }
+    return transitions;
+}
+
+// Время на смены этапов за кадр: колесо таймеров против обхода всех блоков
+void benchmarkTransitions(
+    const size_t blocksCount
+) {
+    constexpr int STEPS = 600;
+    const vector<StageSpec> choreography = createChoreography();
+
+    BlockTweens wheelTweens;
+    initBlockTweens(wheelTweens, choreography, blocksCount);
+    BlockTweens scanTweens = wheelTweens;
+    vector<uint32_t> fired;
+
+    size_t transitions = 0;
+    Clock timer;
+    for (int step = 1; step <= STEPS; ++step) {
+        fireTransitions(wheelTweens, choreography, static_cast<float>(step) / 60.f, fired);
+        transitions += fired.size();
+    }
+    const float wheelElapsed = timer.restart().asSeconds();
+    for (int step = 1; step <= STEPS; ++step) {
+        scanTransitions(scanTweens, choreography, static_cast<float>(step) / 60.f);
+    }
+    const float scanElapsed = timer.getElapsedTime().asSeconds();
+
+    cout << blocksCount << " blocks, " << transitions / STEPS << " transitions per frame" << endl;
+    cout << "timing wheel: " << wheelElapsed * 1e6f / STEPS << " us per frame, "
+        << wheelTweens.transitions.cascaded << " cascaded" << endl;
+    cout << "scan: " << scanElapsed * 1e6f / STEPS << " us per frame" << endl;
+}
+
+// Колесо таймеров против перебора списка: постановки, отмены, в том числе
+// по устаревшим дескрипторам, и продвижения со сроками у границ уровней
+// (255/256/65536 тиков), где таймеры перекладываются; false - колесо
+// сработало не то, не тогда или отменило чужой таймер
+bool verifyTimingWheel() {
+    constexpr int ROUNDS = 2000;
+    constexpr int LONG_STEP_EVERY = 200; // шаг через границу верхнего уровня долгий, он реже
+    constexpr uint64_t LONG_STEP = 16777217;
+    const vector<uint64_t> offsets = {
+        0, 1, 2, 255, 256, 257, 511, 512, 65535, 65536, 65537, 16777215, 16777216, 16777217
+    };
+
+    struct ReferenceTimer {
+        uint64_t deadline = 0;
+        TimerHandle handle;
+        bool isActive = false;
+    };
+    mt19937_64 random(1);
+    TimingWheel wheel;
+    vector<ReferenceTimer> timers;
+    vector<uint32_t> fired;
+    vector<uint32_t> expected;
+    size_t activeCount = 0;
+    size_t cancelled = 0;
+    size_t mismatches = 0;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            const uint64_t offset = random() % 2 == 0 ? offsets[random() % offsets.size()] : random() % 70000;
+            const uint64_t deadline = wheel.now + offset;
+            const auto payload = static_cast<uint32_t>(timers.size());
+            // прошедший срок срабатывает на следующем тике
+            timers.push_back({max(deadline, wheel.now + 1), scheduleTimer(wheel, deadline, payload), true});
+            ++activeCount;
+        }
+        // чаще недавние, еще живые; старые дескрипторы - уже на чужих узлах
+        for (int i = 0; i < 3; ++i) {
+            const size_t range = random() % 2 == 0 ? min<size_t>(timers.size(), 64) : timers.size();
+            ReferenceTimer &timer = timers[timers.size() - 1 - random() % range];
+            if (cancelTimer(wheel, timer.handle) != timer.isActive) {
+                ++mismatches;
+            }
+            if (timer.isActive) {
+                timer.isActive = false;
+                --activeCount;
+                ++cancelled;
+            }
+        }
+
+        const uint64_t step = round % LONG_STEP_EVERY == LONG_STEP_EVERY - 1 ? LONG_STEP
+            : random() % 4 == 0 ? offsets[random() % (offsets.size() - 3)]
+            : random() % 300;
+        const uint64_t target = wheel.now + step;
+        fired.clear();
+        advanceTimingWheel(wheel, target, fired);
+
+        expected.clear();
+        for (uint32_t i = 0; i < timers.size(); ++i) {
+            if (timers[i].isActive && timers[i].deadline <= target) {
+                expected.push_back(i);
+                timers[i].isActive = false;
+                --activeCount;
+            }
+        }
+        for (size_t i = 1; i < fired.size(); ++i) {
+            if (timers[fired[i]].deadline < timers[fired[i - 1]].deadline) {
+                ++mismatches;
+            }
+        }
+        sort(fired.begin(), fired.end());
+        if (fired != expected || wheel.activeCount != activeCount) {
+            ++mismatches;
+        }
+    }
+    cout << "timing wheel: " << timers.size() << " scheduled, " << cancelled << " cancelled, "
+        << wheel.fired << " fired, " << wheel.cascaded << " cascaded, " << mismatches << " mismatches" << endl;
+    return mismatches == 0;
+}
+
+//   02 [--blocks N]      N блоков, по умолчанию 100000
+//      [--bench-tweens] [--verify-tweens] [--verify-timers] [--bench-transitions]
+int main(int argc, char *argv[]) {
+    const vector<string> args(argv + 1, argv + argc);
+    const size_t blocksCount = getCountOption(args, "--blocks", DEFAULT_BLOCKS);
+    if (hasFlag(args, "--verify-tweens")) {
+        return verifyTweenKernels() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (hasFlag(args, "--verify-timers")) {
+        return verifyTimingWheel() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (hasFlag(args, "--bench-tweens")) {
+        benchmarkTweenKernels(blocksCount);
+        return EXIT_SUCCESS;
+    }
+    if (hasFlag(args, "--bench-transitions")) {
+        benchmarkTransitions(blocksCount);
+        return EXIT_SUCCESS;
+    }
+    const ProfilerDump profilerDump("complex_animation_02");
+
+    RenderWindow window(
+        VideoMode({
+            WINDOW_WIDTH,
+            WINDOW_HEIGHT,
+        }),
+        "Complex animation: " + to_string(blocksCount) + " blocks"
+    );
+
+    const vector<StageSpec> choreography = createChoreography();
+    const TweenKernel kernel = detectTweenKernel();
+    BlockTweens tweens;
+    initBlockTweens(tweens, choreography, blocksCount);
+    cout << "tween kernel: " << toString(kernel) << endl;
+
+    // вершины всех блоков каждый кадр уходят в видеопамять одной загрузкой
+    TweenChunk chunk;
+    vector<Vertex> vertices;
+    vector<uint32_t> fired;
+    VertexBuffer buffer(PrimitiveType::Triangles, VertexBuffer::Usage::Stream);
+    const bool hasBuffer = VertexBuffer::isAvailable()
+        && buffer.create(blocksCount * VERTICES_PER_BLOCK);
+
+    Clock clock;
+    FramePacer framePacer;
+    initFramePacer(framePacer, args);
+    while (window.isOpen()) {
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (const auto event = window.pollEvent()) {
+                if (event->is<Event::Closed>()) {
+                    window.close();
+                }
+            }
+        }
+        {
+            PROFILE_ZONE("update");
+            updateTweens(tweens, choreography, clock.getElapsedTime().asSeconds(), kernel, chunk, vertices, fired);
+        }
+        {
+            PROFILE_ZONE("render");
+            window.clear(Color::White);
+            if (hasBuffer && buffer.update(vertices.data())) {
+                window.draw(buffer);
+            } else {
+                window.draw(vertices.data(), vertices.size(), PrimitiveType::Triangles);
+            }
+            PROFILE_ZONE("display");
+            window.display();
+        }
+        waitNextFrame(framePacer);
+    }
+    printPacingReport(framePacer);
+
+    return EXIT_SUCCESS;
+}
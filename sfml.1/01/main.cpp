@@ -1,6 +1,11 @@
 #include <SFML/Graphics.hpp>
 
-int main() {
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_1_01");
+
     sf::RenderWindow window(sf::VideoMode({800, 600}), "Several circles");
 
     window.clear();
@@ -21,19 +26,33 @@ int main() {
     shape4.setFillColor(sf::Color::Blue);
     shape4.setPosition({330, 220});
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = window.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
-        window.draw(shape1);
-        window.draw(shape2);
-        window.draw(shape3);
-        window.draw(shape4);
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.draw(shape1);
+            window.draw(shape2);
+            window.draw(shape3);
+            window.draw(shape4);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
\ No newline at end of file
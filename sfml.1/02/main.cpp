@@ -1,6 +1,11 @@
 #include <SFML/Graphics.hpp>
 
-int main() {
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_1_02");
+
     sf::RenderWindow window(sf::VideoMode({600, 400}), "Rectangles");
 
     sf::RectangleShape rect1({100, 50});
@@ -14,18 +19,32 @@ int main() {
     rect2.setOrigin({40, 20});
     rect2.setRotation(sf::degrees(45));
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = window.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
-        window.clear();
-        window.draw(rect1);
-        window.draw(rect2);
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            window.draw(rect1);
+            window.draw(rect2);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
\ No newline at end of file
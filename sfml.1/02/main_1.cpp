@@ -1,5 +1,8 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 sf::RectangleShape createTrafficLightBody() {
     sf::RectangleShape body({210, 80});
     body.setFillColor(sf::Color(128, 128, 128)); // Серый
@@ -15,23 +18,39 @@ sf::CircleShape createSignal(float radius, const sf::Color& color, const sf::Vec
     return signal;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_1_02_traffic_light");
+
     sf::RenderWindow window(sf::VideoMode({600, 400}), "Traffic light");
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = window.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
-        window.clear();
-        window.draw(createTrafficLightBody());
-        window.draw(createSignal(30.f, sf::Color::Green, {30, 110}));
-        window.draw(createSignal(30.f, sf::Color::Yellow, {30, 175}));
-        window.draw(createSignal(30.f, sf::Color::Red, {30, 240}));
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            window.draw(createTrafficLightBody());
+            window.draw(createSignal(30.f, sf::Color::Green, {30, 110}));
+            window.draw(createSignal(30.f, sf::Color::Yellow, {30, 175}));
+            window.draw(createSignal(30.f, sf::Color::Red, {30, 240}));
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/baked_scene.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 sf::RectangleShape createWhiteRectangle(
     const sf::Vector2f& size,
     const sf::Vector2f& position,
@@ -12,36 +16,60 @@ sf::RectangleShape createWhiteRectangle(
     return rect;
 }
 
-int main() {
-    sf::RenderWindow window(sf::VideoMode({300, 300}), "MVP");
+void addLetters(
+    BakedScene &scene
+) {
+    // M
+    addShape(scene, createWhiteRectangle({10, 100}, {50, 100}));
+    addShape(scene, createWhiteRectangle({10, 40}, {50, 106}, -45));
+    addShape(scene, createWhiteRectangle({10, 38}, {100, 101}, 45));
+    addShape(scene, createWhiteRectangle({10, 100}, {100, 100}));
 
-    while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
-            }
-        }
+    // V
+    addShape(scene, createWhiteRectangle({10, 100}, {120, 100}, -14));
+    addShape(scene, createWhiteRectangle({10, 100}, {170, 98}, 14));
+
+    // P
+    addShape(scene, createWhiteRectangle({10, 90}, {190, 110}));
+    addShape(scene, createWhiteRectangle({40, 10}, {240, 110}, -180));
+    addShape(scene, createWhiteRectangle({40, 10}, {240, 160}, 180));
+    addShape(scene, createWhiteRectangle({10, 40}, {240, 110}));
+}
 
-        window.clear();
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_1_02_mvp");
 
-        // M
-        window.draw(createWhiteRectangle({10, 100}, {50, 100}));
-        window.draw(createWhiteRectangle({10, 40}, {50, 106}, -45));
-        window.draw(createWhiteRectangle({10, 38}, {100, 101}, 45));
-        window.draw(createWhiteRectangle({10, 100}, {100, 100}));
+    sf::RenderWindow window(sf::VideoMode({300, 300}), "MVP");
 
-        // V
-        window.draw(createWhiteRectangle({10, 100}, {120, 100}, -14));
-        window.draw(createWhiteRectangle({10, 100}, {170, 98}, 14));
+    BakedScene letters;
+    addLetters(letters);
+    bakeScene(letters);
 
-        // P
-        window.draw(createWhiteRectangle({10, 90}, {190, 110}));
-        window.draw(createWhiteRectangle({40, 10}, {240, 110}, -180));
-        window.draw(createWhiteRectangle({40, 10}, {240, 160}, 180));
-        window.draw(createWhiteRectangle({10, 40}, {240, 110}));
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
+    while (window.isOpen()) {
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = window.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) {
+                    window.close();
+                }
+            }
+        }
 
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            drawScene(window, letters);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
\ No newline at end of file
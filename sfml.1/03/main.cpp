@@ -1,4 +1,11 @@
 #include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+#include "../../common/baked_scene.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../../common/redraw_gate.h"
 
 sf::RectangleShape createRectangle(
     const sf::Vector2f& size,
@@ -51,77 +58,108 @@ sf::ConvexShape createRoof(
     return trapeze;
 }
 
-int main() {
+void addHouse(
+    BakedScene &scene
+) {
+    // wall
+    addShape(scene, createRectangle(
+        {500, 250},        // размер: ширина, высота
+        {300, 400},        // позиция (левый верхний угол)
+        {77, 47, 10}       // без поворота
+    ));
+    // door
+    addShape(scene, createRectangle(
+        {70, 140},
+        {340, 510},
+        {0, 0, 0}
+    ));
+    // roof
+    addShape(scene, createRoof(
+        200.f,             // ширина верха крыши
+        600.f,             // ширина низа крыши
+        100.f,             // высота крыши
+        {550, 300},        // позиция
+        {93, 30, 22}       // цвет крыши
+    ));
+    // pipe
+    addShape(scene, createRectangle(
+        {30, 80},          // размер: ширина, высота
+        {600, 280},        // позиция (левый верхний угол)
+        {60, 56, 56}
+    ));
+    addShape(scene, createRectangle(
+        {50, 40},          // размер: ширина, высота
+        {590, 240},        // позиция (левый верхний угол)
+        {60, 56, 56}
+    ));
+    // smoke
+    addShape(scene, createCircle(
+        20.f,                          // радиус
+        {191, 191, 191},               // цвет
+        {610, 200}                     // позиция центра
+    ));
+    addShape(scene, createCircle(
+        25.f,                          // радиус
+        {191, 191, 191},               // цвет
+        {620, 180}                     // позиция центра
+    ));
+    addShape(scene, createCircle(
+        30.f,                          // радиус
+        {191, 191, 191},               // цвет
+        {640, 160}                     // позиция центра
+    ));
+    addShape(scene, createCircle(
+        35.f,                          // радиус
+        {191, 191, 191},               // цвет
+        {650, 140}                     // позиция центра
+    ));
+    // window
+    addShape(scene, createRectangle(
+        {80, 80},        // размер: ширина, высота
+        {550, 520},      // позиция (левый верхний угол)
+        {42, 122, 226}
+    ));
+}
+
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_1_03");
+
     sf::RenderWindow window(sf::VideoMode({1000, 800}), "House");
 
+    BakedScene house;
+    addHouse(house);
+    bakeScene(house);
+
+    RedrawGate redrawGate;
+    initRedrawGate(redrawGate, std::vector<std::string>(argv + 1, argv + argc));
+
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = pollRedrawEvent(redrawGate, window)) {
+                if (event->is<sf::Event::Closed>()) {
+                    window.close();
+                }
             }
         }
+        if (!shouldRedraw(redrawGate, framePacer)) {
+            continue;
+        }
 
         window.clear();
-        // wall
-        window.draw(createRectangle(
-            {500, 250},        // размер: ширина, высота
-            {300, 400},        // позиция (левый верхний угол)
-            {77, 47, 10}       // без поворота
-        ));
-        // door
-        window.draw(createRectangle(
-            {70, 140},
-            {340, 510},
-            {0, 0, 0}
-        ));
-        // roof
-        window.draw(createRoof(
-            200.f,             // ширина верха крыши
-            600.f,             // ширина низа крыши
-            100.f,             // высота крыши
-            {550, 300},        // позиция
-            {93, 30, 22}       // цвет крыши
-        ));
-        // pipe
-        window.draw(createRectangle(
-            {30, 80},          // размер: ширина, высота
-            {600, 280},        // позиция (левый верхний угол)
-            {60, 56, 56}
-        ));
-        window.draw(createRectangle(
-            {50, 40},          // размер: ширина, высота
-            {590, 240},        // позиция (левый верхний угол)
-            {60, 56, 56}
-        ));
-        // smoke
-        window.draw(createCircle(
-            20.f,                          // радиус
-            {191, 191, 191},               // цвет
-            {610, 200}                     // позиция центра
-        ));
-        window.draw(createCircle(
-            25.f,                          // радиус
-            {191, 191, 191},               // цвет
-            {620, 180}                     // позиция центра
-        ));
-        window.draw(createCircle(
-            30.f,                          // радиус
-            {191, 191, 191},               // цвет
-            {640, 160}                     // позиция центра
-        ));
-        window.draw(createCircle(
-            35.f,                          // радиус
-            {191, 191, 191},               // цвет
-            {650, 140}                     // позиция центра
-        ));
-		// window
-        window.draw(createRectangle(
-            {80, 80},        // размер: ширина, высота
-            {550, 520},      // позиция (левый верхний угол)
-            {42, 122, 226}
-        ));
-        window.display();
+        drawScene(window, house);
+        {
+            PROFILE_ZONE("display");
+            window.display();
+        }
+        finishRedraw(redrawGate);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
+    printRedrawReport(redrawGate, framePacer);
 
     return 0;
 }
\ No newline at end of file
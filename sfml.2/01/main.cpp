@@ -1,8 +1,13 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_2_01");
+
     constexpr float BALL_SIZE = 40;
     constexpr unsigned WINDOW_WIDTH = 800;
     constexpr unsigned WINDOW_HEIGHT = 600;
@@ -17,10 +22,16 @@ int main() {
 
     Vector2f speed = {200.f, 200.f};
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (const auto event = window.pollEvent()) {
-            if (event->is<Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (const auto event = window.pollEvent()) {
+                if (event->is<Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
@@ -43,8 +54,16 @@ int main() {
 
         shape.setPosition(newPosition);
 
-        window.clear();
-        window.draw(shape);
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            window.draw(shape);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
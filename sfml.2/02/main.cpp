@@ -1,12 +1,17 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
 constexpr unsigned WINDOW_WIDTH = 800;
 constexpr unsigned WINDOW_HEIGHT = 600;
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_2_02");
+
     constexpr float BALL_SIZE = 40;
 
     RenderWindow window(VideoMode({
@@ -19,10 +24,16 @@ int main() {
     CircleShape ball(BALL_SIZE);
     ball.setFillColor(Color(0xFF, 0xFF, 0xFF));
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (const auto event = window.pollEvent()) {
-            if (event->is<Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (const auto event = window.pollEvent()) {
+                if (event->is<Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
@@ -38,8 +49,16 @@ int main() {
 
         ball.setPosition(position + offset);
 
-        window.clear();
-        window.draw(ball);
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            window.draw(ball);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
\ No newline at end of file
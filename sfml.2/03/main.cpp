@@ -1,5 +1,11 @@
 #include <SFML/Graphics.hpp>
-#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../../common/redraw_gate.h"
+#include "../../common/tessellation_cache.h"
 
 using namespace sf;
 using namespace std;
@@ -7,8 +13,9 @@ using namespace std;
 constexpr unsigned WINDOW_WIDTH = 800;
 constexpr unsigned WINDOW_HEIGHT = 600;
 
-int main() {
-    constexpr int pointCount = 200;
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_2_03");
+
     constexpr Vector2f ellipseRadius = {200.0f, 80.f};
 
     ContextSettings settings;
@@ -22,26 +29,44 @@ int main() {
     ConvexShape ellipse;
     ellipse.setPosition({WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f});
     ellipse.setFillColor(Color(0xFF, 0xFF, 0xFF, 0xFF));
-    ellipse.setPointCount(pointCount);
-
-    for (int pointNumber = 0; pointNumber < pointCount; ++pointNumber) {
-        const float angle = float(2 * M_PI * pointNumber) / float(pointCount);
-        Vector2f point = Vector2f{
-            ellipseRadius.x * sin(angle),
-            ellipseRadius.y * cos(angle)
-        };
-        ellipse.setPoint(pointNumber, point);
-    }
 
+    TessellationCache tessellationCache;
+    setShapePoints(
+        ellipse,
+        *getEllipsePoints(tessellationCache, ellipseRadius, getEllipsePointCount(ellipseRadius))
+    );
+
+    RedrawGate redrawGate;
+    initRedrawGate(redrawGate, vector<string>(argv + 1, argv + argc));
+
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        while (auto event = window.pollEvent()) {
-            if (event->is<Event::Closed>()) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            while (auto event = pollRedrawEvent(redrawGate, window)) {
+                if (event->is<Event::Closed>()) {
+                    window.close();
+                }
             }
         }
+        if (!shouldRedraw(redrawGate, framePacer)) {
+            continue;
+        }
 
-        window.clear();
-        window.draw(ellipse);
-        window.display();
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            window.draw(ellipse);
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        finishRedraw(redrawGate);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
+    printRedrawReport(redrawGate, framePacer);
 }
@@ -1,5 +1,8 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -17,12 +20,18 @@ void initBall(
 }
 
 void redrawFrame(RenderWindow &window, CircleShape &ball) {
+    PROFILE_ZONE("render");
     window.clear();
     window.draw(ball);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml2_1");
+
     RenderWindow window(VideoMode({
                             WINDOW_WIDTH,
                             WINDOW_HEIGHT
@@ -37,7 +46,10 @@ int main() {
     CircleShape ball(BALL_SIZE);
     initBall(ball, {0xFF, 0xFF, 0xFF}, position);
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         while (const auto event = window.pollEvent()) {
             if (event->is<Event::Closed>()) {
                 window.close();
@@ -59,5 +71,7 @@ int main() {
         ball.setPosition({position.x, position.y + offsetY});
 
         redrawFrame(window, ball);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -1,38 +1,168 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../common/command_line.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../../common/tessellation_cache.h"
+#include "rose_field.h"
 
 using namespace sf;
 using namespace std;
 
 constexpr unsigned WINDOW_WIDTH = 800;
 constexpr unsigned WINDOW_HEIGHT = 600;
+// общий период орбиты, пульсации и поворотов роз: 8 pi делится на все
+// их периоды, поэтому время по модулю периода не дает скачка, а float
+// не теряет точность за долгую работу
+constexpr float ANIMATION_PERIOD = 8.f * ROSE_PI;
 
 void initRose(
     ConvexShape &rose,
     const Color &color,
-    const Vector2f &windowSize,
-    const int pointCount) {
+    const Vector2f &windowSize) {
     rose.setPosition(windowSize);
     rose.setFillColor(Color(color));
-    rose.setPointCount(pointCount);
 }
 
-void drawRose(ConvexShape &rose, const int pointCount) {
-    for (int pointNumber = 0; pointNumber < pointCount; ++pointNumber) {
-        constexpr int petalCount = 6;
-        const float baseRadius = 200.f;
-        const float angle = static_cast<float>(2 * M_PI * pointNumber) / static_cast<float>(pointCount);
-        const float radius = baseRadius * sin(petalCount * angle);
-        const Vector2f point = Vector2f{
-            radius * sin(angle),
-            radius * cos(angle)
+// Число точек подбирается так, чтобы кончики лепестков не были угловатыми
+void drawRose(ConvexShape &rose, TessellationCache &tessellationCache) {
+    constexpr float petalCount = 6;
+    constexpr float baseRadius = 200.f;
+    const size_t pointCount = getRosePointCount(baseRadius, petalCount);
+    setShapePoints(rose, *getRosePoints(tessellationCache, baseRadius, petalCount, pointCount));
+}
+
+// Сетка роз на всё окно: число лепестков и радиус у соседей разные,
+// число точек каждой розы подобрано по ее наибольшему радиусу
+void initRoseField(
+    RoseField &field,
+    const size_t rosesCount
+) {
+    if (rosesCount == 0) {
+        return;
+    }
+    const auto columns = static_cast<size_t>(ceil(sqrt(
+        static_cast<float>(rosesCount) * WINDOW_WIDTH / WINDOW_HEIGHT)));
+    const size_t rows = (rosesCount + columns - 1) / columns;
+    const Vector2f cell = {
+        static_cast<float>(WINDOW_WIDTH) / static_cast<float>(columns),
+        static_cast<float>(WINDOW_HEIGHT) / static_cast<float>(rows)
+    };
+    for (size_t i = 0; i < rosesCount; ++i) {
+        Rose rose;
+        rose.center = {
+            (static_cast<float>(i % columns) + 0.5f) * cell.x,
+            (static_cast<float>(i / columns) + 0.5f) * cell.y
         };
-        rose.setPoint(pointNumber, point);
+        rose.radius = 0.5f * min(cell.x, cell.y) * (0.6f + 0.4f * static_cast<float>(i % 5) / 4.f);
+        rose.petalCount = static_cast<float>(2 + i % 8);
+        rose.color = Color(0xFF, static_cast<uint8_t>(0x09 + i * 37 % 0xC0), 0x80);
+        addRose(field, rose, getRosePointCount(rose.radius, rose.petalCount));
+    }
+}
+
+// Розы крутятся и пульсируют, каждая со своей фазой
+void updateRoseField(
+    RoseField &field,
+    const vector<float> &baseRadius,
+    const float time
+) {
+    for (size_t i = 0; i < field.roses.size(); ++i) {
+        const float phase = static_cast<float>(i) * 0.7f;
+        // поворот уходит в sinCos ядер, он должен оставаться в [0, 2 pi)
+        field.roses[i].rotation = fmod(time * (0.5f + static_cast<float>(i % 3) * 0.25f), 2.f * ROSE_PI);
+        field.roses[i].radius = baseRadius[i] * (0.8f + 0.2f * sin(2.f * time + phase));
+    }
+}
+
+// Режим проверки: ошибка векторных sin/cos против double на |x| <= 1000
+// и наибольшее расхождение точек роз с вычислением через libm; false -
+// какое-то ядро вышло за гарантии из rose_field.h
+bool verifyRoseKernels() {
+    constexpr float RANGE = SIN_COS_RANGE;
+    constexpr size_t SAMPLES = 1 << 22;
+
+    vector<float> x(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        x[i] = -RANGE + 2.f * RANGE * static_cast<float>(i) / static_cast<float>(SAMPLES);
+    }
+    vector<float> sinX(SAMPLES);
+    vector<float> cosX(SAMPLES);
+
+    RoseField reference;
+    initRoseField(reference, 1000);
+    evaluateRoses(reference, RoseKernel::Scalar);
+
+    bool allWithinBounds = true;
+    for (const RoseKernel kernel: getSupportedRoseKernels()) {
+        if (kernel == RoseKernel::Scalar) {
+            continue;
+        }
+        evaluateSinCos(kernel, x.data(), sinX.data(), cosX.data(), SAMPLES);
+        double maxError = 0;
+        for (size_t i = 0; i < SAMPLES; ++i) {
+            maxError = max(maxError, abs(sinX[i] - sin(static_cast<double>(x[i]))));
+            maxError = max(maxError, abs(cosX[i] - cos(static_cast<double>(x[i]))));
+        }
+
+        RoseField vectorized = reference;
+        evaluateRoses(vectorized, kernel);
+        float maxDistance = 0;
+        for (size_t i = 0; i < reference.points.size(); ++i) {
+            const Vector2f diff = vectorized.points[i] - reference.points[i];
+            maxDistance = max(maxDistance, sqrt(diff.x * diff.x + diff.y * diff.y));
+        }
+        const bool isWithinBounds = maxError <= SIN_COS_MAX_ERROR && maxDistance <= ROSE_MAX_POINT_OFFSET;
+        cout << toString(kernel) << ": sin/cos error " << maxError
+                << ", max point offset from libm " << maxDistance << " px: "
+                << (isWithinBounds ? "ok" : "OUT OF BOUNDS") << endl;
+        allWithinBounds = allWithinBounds && isWithinBounds;
     }
+    return allWithinBounds;
 }
 
-int main() {
-    constexpr int pointCount = 200;
+// Микробенчмарк: точек роз в секунду для каждого набора инструкций
+void benchmarkRoseKernels() {
+    constexpr size_t ROSES_COUNT = 10000;
+    constexpr int STEPS = 50;
+
+    RoseField field;
+    initRoseField(field, ROSES_COUNT);
+    vector<float> baseRadius;
+    for (const Rose &rose: field.roses) {
+        baseRadius.push_back(rose.radius);
+    }
+    for (const RoseKernel kernel: getSupportedRoseKernels()) {
+        Clock timer;
+        for (int step = 0; step < STEPS; ++step) {
+            updateRoseField(field, baseRadius, static_cast<float>(step) / 60.f);
+            evaluateRoses(field, kernel);
+        }
+        const float elapsed = timer.getElapsedTime().asSeconds();
+        const double pointsPerSecond = static_cast<double>(field.points.size()) * STEPS / elapsed;
+        cout << toString(kernel) << ": " << pointsPerSecond / 1e6 << " M points/s" << endl;
+    }
+}
+
+//   sfml2_2 [--roses N]     N анимированных роз вместо одной
+//           [--bench-roses] [--verify-roses]
+int main(int argc, char *argv[]) {
+    const vector<string> args(argv + 1, argv + argc);
+    if (hasFlag(args, "--verify-roses")) {
+        return verifyRoseKernels() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (hasFlag(args, "--bench-roses")) {
+        benchmarkRoseKernels();
+        return EXIT_SUCCESS;
+    }
+    const ProfilerDump profilerDump("sfml2_2");
+
     constexpr Vector2f orbitCenter = {WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f};
 
     ContextSettings settings;
@@ -46,24 +176,41 @@ int main() {
     Clock clock;
     float time = 0.f;
 
+    TessellationCache tessellationCache;
     ConvexShape rose;
     initRose(
         rose,
         {0xFF, 0x09, 0x80},
-        {WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f},
-        pointCount
+        {WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f}
     );
-    drawRose(rose, pointCount);
+    drawRose(rose, tessellationCache);
+
+    // поле роз считается векторным ядром и рисуется одним массивом треугольников
+    const size_t rosesCount = getCountOption(args, "--roses", 0);
+    const RoseKernel kernel = detectRoseKernel();
+    RoseField field;
+    vector<float> baseRadius;
+    VertexArray fieldTriangles;
+    initRoseField(field, rosesCount);
+    for (const Rose &fieldRose: field.roses) {
+        baseRadius.push_back(fieldRose.radius);
+    }
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, args);
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         constexpr float orbitRadius = 100.f;
         constexpr float speed = 1.5f;
         const float deltaTime = clock.restart().asSeconds();
-        time += deltaTime;
+        time = fmod(time + deltaTime, ANIMATION_PERIOD);
 
-        while (const auto event = window.pollEvent()) {
-            if (event->is<Event::Closed>()) {
-                window.close();
+        {
+            PROFILE_ZONE("pollEvents");
+            while (const auto event = window.pollEvent()) {
+                if (event->is<Event::Closed>()) {
+                    window.close();
+                }
             }
         }
 
@@ -75,8 +222,27 @@ int main() {
 
         rose.setPosition(newPosition);
 
-        window.clear();
-        window.draw(rose);
-        window.display();
+        if (rosesCount > 0) {
+            PROFILE_ZONE("update");
+            updateRoseField(field, baseRadius, time);
+            evaluateRoses(field, kernel);
+            buildRoseTriangles(field, fieldTriangles);
+        }
+
+        {
+            PROFILE_ZONE("render");
+            window.clear();
+            if (rosesCount > 0) {
+                window.draw(fieldTriangles);
+            } else {
+                window.draw(rose);
+            }
+            {
+                PROFILE_ZONE("display");
+                window.display();
+            }
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
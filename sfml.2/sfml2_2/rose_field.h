@@ -0,0 +1,390 @@
+// Поле полярных роз r = R sin(k t). Точки всех роз лежат подряд в одном
+// буфере, и векторные ядра считают их по 4 (SSE2) или 8 (AVX2) за раз
+// со своими sin/cos вместо вызова libm на каждую точку.
+//
+// Приближение sin/cos: аргумент приводится к [-pi/4, pi/4] вычитанием
+// j * pi/2 в три шага (Коди - Уэйт), дальше минимаксные многочлены Cephes.
+// Абсолютная ошибка против double не больше 1e-7 при |x| <= 1000
+// (замер --verify-roses: 9.3e-8); для роз радиусом до 1000 пикселей
+// это меньше тысячной пикселя. Дальше 1000 радиан ошибка растет из-за
+// приведения аргумента. Здесь t в [0, 2 pi), поворот rotation в [0, 2 pi),
+// поэтому аргументы не больше 2 pi * k и t + rotation < 4 pi
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define ROSES_HAVE_SSE2 1
+#if defined(__GNUC__)
+#define ROSES_HAVE_AVX2 1
+#endif
+#endif
+
+using namespace sf;
+using namespace std;
+
+// гарантии из шапки, их проверяет --verify-roses
+constexpr float SIN_COS_RANGE = 1000.f;
+constexpr double SIN_COS_MAX_ERROR = 1e-7;
+constexpr float ROSE_MAX_POINT_OFFSET = 1e-3f; // пикселей, при радиусе до 1000
+
+constexpr float ROSE_PI = 3.14159265358979f;
+// pi/2 в виде суммы трех float: произведения j * ROSE_PIO2_1 и j * ROSE_PIO2_2 точные
+constexpr float ROSE_PIO2_1 = 1.5703125f;
+constexpr float ROSE_PIO2_2 = 4.837512969970703125e-4f;
+constexpr float ROSE_PIO2_3 = 7.54978995489188216e-8f;
+constexpr float ROSE_2_PI = 0.636619772367581f; // 2 / pi
+// многочлены на [-pi/4, pi/4]
+constexpr float SIN_C1 = -1.6666654611e-1f;
+constexpr float SIN_C2 = 8.3321608736e-3f;
+constexpr float SIN_C3 = -1.9515295891e-4f;
+constexpr float COS_C1 = 4.166664568298827e-2f;
+constexpr float COS_C2 = -1.388731625493765e-3f;
+constexpr float COS_C3 = 2.443315711809948e-5f;
+
+struct Rose {
+    Vector2f center;
+    float radius = 0;
+    float petalCount = 0;
+    float rotation = 0; // поворот всей розы, радианы в [0, 2 pi)
+    Color color;
+};
+
+// Розы и их точки: точки розы i лежат в points с firstPoint[i]
+// до firstPoint[i + 1]. Число точек розы задается один раз в addRose,
+// дальше меняются только параметры
+struct RoseField {
+    vector<Rose> roses;
+    vector<uint32_t> firstPoint = {0};
+    vector<Vector2f> points;
+};
+
+inline void addRose(
+    RoseField &field,
+    const Rose &rose,
+    const size_t pointCount
+) {
+    field.roses.push_back(rose);
+    field.firstPoint.push_back(field.firstPoint.back() + static_cast<uint32_t>(pointCount));
+    field.points.resize(field.firstPoint.back());
+}
+
+inline size_t getPointCount(
+    const RoseField &field,
+    const size_t rose
+) {
+    return field.firstPoint[rose + 1] - field.firstPoint[rose];
+}
+
+// Набор инструкций для вычисления точек роз
+enum class RoseKernel {
+    Scalar, // sin/cos из libm, как в исходном drawRose
+    Sse2,
+    Avx2
+};
+
+inline const char *toString(const RoseKernel kernel) {
+    switch (kernel) {
+        case RoseKernel::Sse2:
+            return "sse2";
+        case RoseKernel::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+inline RoseKernel detectRoseKernel() {
+#if ROSES_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return RoseKernel::Avx2;
+    }
+#endif
+#if ROSES_HAVE_SSE2
+    return RoseKernel::Sse2;
+#else
+    return RoseKernel::Scalar;
+#endif
+}
+
+inline vector<RoseKernel> getSupportedRoseKernels() {
+    vector<RoseKernel> kernels = {RoseKernel::Scalar};
+    const RoseKernel best = detectRoseKernel();
+    if (best == RoseKernel::Sse2 || best == RoseKernel::Avx2) {
+        kernels.push_back(RoseKernel::Sse2);
+    }
+    if (best == RoseKernel::Avx2) {
+        kernels.push_back(RoseKernel::Avx2);
+    }
+    return kernels;
+}
+
+inline void evaluateRoseScalar(
+    const Rose &rose,
+    const size_t pointCount,
+    Vector2f *points
+) {
+    for (size_t i = 0; i < pointCount; ++i) {
+        const float angle = static_cast<float>(2 * M_PI * i) / static_cast<float>(pointCount);
+        const float radius = rose.radius * sin(rose.petalCount * angle);
+        points[i] = {
+            rose.center.x + radius * sin(angle + rose.rotation),
+            rose.center.y + radius * cos(angle + rose.rotation)
+        };
+    }
+}
+
+#if ROSES_HAVE_SSE2
+// sin и cos четырех чисел сразу, см. оценку ошибки в начале файла
+inline void sinCosSse2(
+    const __m128 x,
+    __m128 &sinX,
+    __m128 &cosX
+) {
+    const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(ROSE_2_PI)));
+    const __m128 j = _mm_cvtepi32_ps(quadrant);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(ROSE_PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(ROSE_PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(ROSE_PIO2_3)));
+
+    const __m128 r2 = _mm_mul_ps(r, r);
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C3), r2), _mm_set1_ps(SIN_C2));
+    s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(SIN_C1));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C3), r2), _mm_set1_ps(COS_C2));
+    c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(COS_C1));
+    c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, r2), r2), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)));
+
+    // четверть j: в нечетных sin и cos меняются местами, знаки - по j & 2 и (j + 1) & 2
+    const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    sinX = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+    cosX = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+}
+
+// Точки одной розы; последний неполный блок считается в запасной буфер
+inline void evaluateRoseSse2(
+    const Rose &rose,
+    const size_t pointCount,
+    Vector2f *points
+) {
+    constexpr size_t LANES = 4;
+    const __m128 step = _mm_set1_ps(2.f * ROSE_PI / static_cast<float>(pointCount));
+    const __m128 petalCount = _mm_set1_ps(rose.petalCount);
+    const __m128 radius = _mm_set1_ps(rose.radius);
+    const __m128 rotation = _mm_set1_ps(rose.rotation);
+    const __m128 centerX = _mm_set1_ps(rose.center.x);
+    const __m128 centerY = _mm_set1_ps(rose.center.y);
+    __m128 index = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+
+    for (size_t i = 0; i < pointCount; i += LANES) {
+        const __m128 angle = _mm_mul_ps(index, step);
+        __m128 petalSin;
+        __m128 petalCos;
+        sinCosSse2(_mm_mul_ps(petalCount, angle), petalSin, petalCos);
+        __m128 sinAngle;
+        __m128 cosAngle;
+        sinCosSse2(_mm_add_ps(angle, rotation), sinAngle, cosAngle);
+        const __m128 r = _mm_mul_ps(radius, petalSin);
+        const __m128 x = _mm_add_ps(centerX, _mm_mul_ps(r, sinAngle));
+        const __m128 y = _mm_add_ps(centerY, _mm_mul_ps(r, cosAngle));
+
+        // x0 y0 x1 y1 | x2 y2 x3 y3 - как лежат Vector2f
+        alignas(16) float block[2 * LANES];
+        float *output = i + LANES <= pointCount ? reinterpret_cast<float *>(points + i) : block;
+        _mm_storeu_ps(output, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(output + LANES, _mm_unpackhi_ps(x, y));
+        if (output == block) {
+            copy_n(reinterpret_cast<const Vector2f *>(block), pointCount - i, points + i);
+        }
+        index = _mm_add_ps(index, _mm_set1_ps(LANES));
+    }
+}
+#endif
+
+#if ROSES_HAVE_AVX2
+__attribute__((target("avx2")))
+inline void sinCosAvx2(
+    const __m256 x,
+    __m256 &sinX,
+    __m256 &cosX
+) {
+    const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(ROSE_2_PI)));
+    const __m256 j = _mm256_cvtepi32_ps(quadrant);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(ROSE_PIO2_1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(ROSE_PIO2_2)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(ROSE_PIO2_3)));
+
+    const __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C3), r2), _mm256_set1_ps(SIN_C2));
+    s = _mm256_add_ps(_mm256_mul_ps(s, r2), _mm256_set1_ps(SIN_C1));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, r2), r), r);
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C3), r2), _mm256_set1_ps(COS_C2));
+    c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(COS_C1));
+    c = _mm256_add_ps(
+        _mm256_mul_ps(_mm256_mul_ps(c, r2), r2),
+        _mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_mul_ps(_mm256_set1_ps(0.5f), r2))
+    );
+
+    const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+    const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    sinX = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+    cosX = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+}
+
+__attribute__((target("avx2")))
+inline void evaluateRoseAvx2(
+    const Rose &rose,
+    const size_t pointCount,
+    Vector2f *points
+) {
+    constexpr size_t LANES = 8;
+    const __m256 step = _mm256_set1_ps(2.f * ROSE_PI / static_cast<float>(pointCount));
+    const __m256 petalCount = _mm256_set1_ps(rose.petalCount);
+    const __m256 radius = _mm256_set1_ps(rose.radius);
+    const __m256 rotation = _mm256_set1_ps(rose.rotation);
+    const __m256 centerX = _mm256_set1_ps(rose.center.x);
+    const __m256 centerY = _mm256_set1_ps(rose.center.y);
+    __m256 index = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+
+    for (size_t i = 0; i < pointCount; i += LANES) {
+        const __m256 angle = _mm256_mul_ps(index, step);
+        __m256 petalSin;
+        __m256 petalCos;
+        sinCosAvx2(_mm256_mul_ps(petalCount, angle), petalSin, petalCos);
+        __m256 sinAngle;
+        __m256 cosAngle;
+        sinCosAvx2(_mm256_add_ps(angle, rotation), sinAngle, cosAngle);
+        const __m256 r = _mm256_mul_ps(radius, petalSin);
+        const __m256 x = _mm256_add_ps(centerX, _mm256_mul_ps(r, sinAngle));
+        const __m256 y = _mm256_add_ps(centerY, _mm256_mul_ps(r, cosAngle));
+
+        // unpack работает внутри 128-битных половин, permute возвращает порядок точек
+        const __m256 low = _mm256_unpacklo_ps(x, y);
+        const __m256 high = _mm256_unpackhi_ps(x, y);
+        alignas(32) float block[2 * LANES];
+        float *output = i + LANES <= pointCount ? reinterpret_cast<float *>(points + i) : block;
+        _mm256_storeu_ps(output, _mm256_permute2f128_ps(low, high, 0x20));
+        _mm256_storeu_ps(output + LANES, _mm256_permute2f128_ps(low, high, 0x31));
+        if (output == block) {
+            copy_n(reinterpret_cast<const Vector2f *>(block), pointCount - i, points + i);
+        }
+        index = _mm256_add_ps(index, _mm256_set1_ps(LANES));
+    }
+}
+#endif
+
+#if ROSES_HAVE_AVX2
+__attribute__((target("avx2")))
+inline size_t evaluateSinCosAvx2(
+    const float *x,
+    float *sinX,
+    float *cosX,
+    const size_t count
+) {
+    constexpr size_t LANES = 8;
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        __m256 s;
+        __m256 c;
+        sinCosAvx2(_mm256_loadu_ps(x + i), s, c);
+        _mm256_storeu_ps(sinX + i, s);
+        _mm256_storeu_ps(cosX + i, c);
+    }
+    return i;
+}
+#endif
+
+// sin/cos массива тем же приближением, что у ядер роз; для проверки точности.
+// Хвост, не кратный ширине вектора, считается через libm
+inline void evaluateSinCos(
+    const RoseKernel kernel,
+    const float *x,
+    float *sinX,
+    float *cosX,
+    const size_t count
+) {
+    size_t done = 0;
+    switch (kernel) {
+#if ROSES_HAVE_AVX2
+        case RoseKernel::Avx2:
+            done = evaluateSinCosAvx2(x, sinX, cosX, count);
+            break;
+#endif
+#if ROSES_HAVE_SSE2
+        case RoseKernel::Sse2:
+            for (; done + 4 <= count; done += 4) {
+                __m128 s;
+                __m128 c;
+                sinCosSse2(_mm_loadu_ps(x + done), s, c);
+                _mm_storeu_ps(sinX + done, s);
+                _mm_storeu_ps(cosX + done, c);
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; done < count; ++done) {
+        sinX[done] = sin(x[done]);
+        cosX[done] = cos(x[done]);
+    }
+}
+
+// Пересчитать точки всех роз поля
+inline void evaluateRoses(
+    RoseField &field,
+    const RoseKernel kernel
+) {
+    for (size_t i = 0; i < field.roses.size(); ++i) {
+        const size_t pointCount = getPointCount(field, i);
+        Vector2f *points = field.points.data() + field.firstPoint[i];
+        switch (kernel) {
+#if ROSES_HAVE_AVX2
+            case RoseKernel::Avx2:
+                evaluateRoseAvx2(field.roses[i], pointCount, points);
+                break;
+#endif
+#if ROSES_HAVE_SSE2
+            case RoseKernel::Sse2:
+                evaluateRoseSse2(field.roses[i], pointCount, points);
+                break;
+#endif
+            default:
+                evaluateRoseScalar(field.roses[i], pointCount, points);
+                break;
+        }
+    }
+}
+
+// Треугольники веером из центра каждой розы, все розы в одном массиве:
+// поле рисуется одним draw
+inline void buildRoseTriangles(
+    const RoseField &field,
+    VertexArray &triangles
+) {
+    triangles.setPrimitiveType(PrimitiveType::Triangles);
+    triangles.resize(3 * field.points.size());
+    size_t vertex = 0;
+    for (size_t i = 0; i < field.roses.size(); ++i) {
+        const Rose &rose = field.roses[i];
+        const size_t first = field.firstPoint[i];
+        const size_t pointCount = getPointCount(field, i);
+        for (size_t point = 0; point < pointCount; ++point) {
+            const size_t next = point + 1 < pointCount ? point + 1 : 0;
+            triangles[vertex++] = Vertex{rose.center, rose.color};
+            triangles[vertex++] = Vertex{field.points[first + point], rose.color};
+            triangles[vertex++] = Vertex{field.points[first + next], rose.color};
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -8,6 +11,7 @@ constexpr unsigned WINDOW_WIDTH = 800;
 constexpr unsigned WINDOW_HEIGHT = 600;
 
 void poleEvents(RenderWindow &window) {
+    PROFILE_ZONE("pollEvents");
     while (auto const event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -37,15 +41,26 @@ void poleEvents(RenderWindow &window) {
 }
 
 void redrawWindow(RenderWindow &window) {
+    PROFILE_ZONE("render");
     window.clear();
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_3_02");
+
     RenderWindow window(VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}),
                         "Mouse Events To Terminal");
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         poleEvents(window);
         redrawWindow(window);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
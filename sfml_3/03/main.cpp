@@ -1,6 +1,9 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace std;
 using namespace sf;
 
@@ -54,6 +57,7 @@ void onMouseMove(const Event::MouseMoved &evt, Vector2f &mousePosition) {
 }
 
 void pollEvents(RenderWindow &window, Vector2f &mousePosition) {
+    PROFILE_ZONE("pollEvents");
     while (const auto event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -65,19 +69,26 @@ void pollEvents(RenderWindow &window, Vector2f &mousePosition) {
 }
 
 void update(const Vector2f &mousePosition, Arrow &arrow) {
+    PROFILE_ZONE("update");
     const Vector2f delta = mousePosition - arrow.position;
     arrow.rotation = atan2(delta.y, delta.x);
     updateArrowElements(arrow);
 }
 
 void redraw(RenderWindow &window, const Arrow &arrow) {
+    PROFILE_ZONE("render");
     window.clear();
     window.draw(arrow.head);
     window.draw(arrow.stem);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_3_03");
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
     RenderWindow window(
@@ -92,9 +103,14 @@ int main() {
     Vector2f mousePosition;
 
     initArrow(arrow);
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window, mousePosition);
         update(mousePosition, arrow);
         redraw(window, arrow);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <algorithm>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -39,6 +42,7 @@ void init(ConvexShape &pointer) {
 }
 
 void pollEvents(RenderWindow &window, Vector2f &mousePosition) {
+    PROFILE_ZONE("pollEvents");
     while (const auto event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -54,6 +58,7 @@ void update(
     ConvexShape &pointer,
     const float &dt
 ) {
+    PROFILE_ZONE("update");
     const Vector2f delta = mousePosition - pointer.getPosition();
     const float targetAngle = toDegrees(atan2(delta.y, delta.x));
 
@@ -68,12 +73,18 @@ void update(
 }
 
 void renderFrame(RenderWindow &window, const ConvexShape &pointer) {
+    PROFILE_ZONE("render");
     window.clear();
     window.draw(pointer);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_3_1");
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -88,9 +99,14 @@ int main() {
     init(pointer);
     Clock clock;
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window, mousePosition);
         update(mousePosition, pointer, clock.restart().asSeconds());
         renderFrame(window, pointer);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -1,6 +1,12 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
 
+#include "../../common/input_replay.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/layer_cache.h"
+#include "../../common/profiler.h"
+#include "../../common/tessellation_cache.h"
+
 using namespace sf;
 using namespace std;
 
@@ -15,38 +21,22 @@ constexpr unsigned WINDOW_HEIGHT = 800;
 constexpr Vector2f BASE_RADIUS = {80.f, 160.f};
 constexpr Vector2f PUPIL_RADIUS = {20.f, 40.f};
 
-void initEllipse(
-    ConvexShape &ellipse,
-    const Vector2f &radius,
-    const int &pointCount
-) {
-    for (int pointNumber = 0; pointNumber < pointCount; ++pointNumber) {
-        const float angle = static_cast<float>(2 * M_PI * pointNumber) / static_cast<float>(pointCount);
-        const Vector2f point = {
-            radius.x * sin(angle),
-            radius.y * cos(angle)
-        };
-        ellipse.setPoint(pointNumber, point);
-    }
-}
-
+// Глаза одного размера берут точки белка и зрачка из общего кеша
 void initEye(
     Eye &eye,
-    const Vector2f &eyePosition
+    const Vector2f &eyePosition,
+    TessellationCache &tessellationCache
 ) {
-    constexpr int pointCount = 200;
     eye.position = eyePosition;
     eye.base.setPosition(eyePosition);
     eye.base.setFillColor(Color::White);
-    eye.base.setPointCount(pointCount);
 
     eye.pupil.setPosition(eyePosition);
     eye.pupil.setFillColor(Color::Black);
-    eye.pupil.setPointCount(pointCount);
 
-    initEllipse(eye.base, BASE_RADIUS, pointCount);
-    initEllipse(eye.pupil, PUPIL_RADIUS, pointCount);
-};
+    setShapePoints(eye.base, *getEllipsePoints(tessellationCache, BASE_RADIUS, getEllipsePointCount(BASE_RADIUS)));
+    setShapePoints(eye.pupil, *getEllipsePoints(tessellationCache, PUPIL_RADIUS, getEllipsePointCount(PUPIL_RADIUS)));
+}
 
 void onMouseMove(
     const Event::MouseMoved &evt,
@@ -55,8 +45,9 @@ void onMouseMove(
     mousePosition = Vector2f(evt.position);
 }
 
-void pollEvents(RenderWindow &window, Vector2f &mousePosition) {
-    while (const auto event = window.pollEvent()) {
+void pollEvents(RenderWindow &window, InputSession &input, Vector2f &mousePosition) {
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = pollInputEvent(input, window)) {
         if (event->is<Event::Closed>()) {
             window.close();
         }
@@ -88,6 +79,7 @@ void update(
     const Vector2f &mousePosition,
     Eye &eye
 ) {
+    PROFILE_ZONE("update");
     constexpr float coefficient = 1.5f;
     constexpr Vector2f maxOffset = {
         BASE_RADIUS.x / coefficient - PUPIL_RADIUS.x,
@@ -98,20 +90,36 @@ void update(
     eye.pupil.setPosition(eye.position + offset);
 }
 
+// Белки не двигаются и лежат в слое-кеше, каждый кадр рисуются только зрачки
 void rerender(
     RenderWindow &window,
+    CachedLayer &eyeBases,
     const Eye &leftEye,
     const Eye &rightEye
 ) {
+    PROFILE_ZONE("render");
     window.clear();
-    window.draw(leftEye.base);
+    drawCachedLayer(window, eyeBases, [&](RenderTarget &target, const RenderStates &states) {
+        target.draw(leftEye.base, states);
+        target.draw(rightEye.base, states);
+    });
     window.draw(leftEye.pupil);
-    window.draw(rightEye.base);
     window.draw(rightEye.pupil);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+// --record file / --replay file / --replay-fast file: см. input_replay.h
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("sfml_3_2");
+
+    InputSession input;
+    if (!initInputSession(input, vector<string>(argv + 1, argv + argc))) {
+        return EXIT_FAILURE;
+    }
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
     RenderWindow window(
@@ -125,17 +133,38 @@ int main() {
     Eye leftEye, rightEye;
     Vector2f mousePosition;
 
+    TessellationCache tessellationCache;
     initEye(leftEye, {
                 WINDOW_WIDTH / 2.f - 100, WINDOW_HEIGHT / 2.f
-            });
+            }, tessellationCache);
     initEye(rightEye, {
                 WINDOW_WIDTH / 2.f + 100, WINDOW_HEIGHT / 2.f
-            });
-
+            }, tessellationCache);
+
+    // слой только на прямоугольник вокруг белков; без него белки рисуются напрямую
+    CachedLayer eyeBases;
+    constexpr Vector2f EDGE_MARGIN = {1.f, 1.f}; // сглаженный край выходит за контур
+    const Vector2f basesTopLeft = leftEye.position - BASE_RADIUS - EDGE_MARGIN;
+    const Vector2f basesBottomRight = rightEye.position + BASE_RADIUS + EDGE_MARGIN;
+    initLayer(eyeBases, "eye bases", {basesTopLeft, basesBottomRight - basesTopLeft}, settings);
+
+    Clock clock;
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        pollEvents(window, mousePosition);
+        PROFILE_ZONE("frame");
+        pollEvents(window, input, mousePosition);
         update(mousePosition, leftEye);
         update(mousePosition, rightEye);
-        rerender(window, leftEye, rightEye);
+        rerender(window, eyeBases, leftEye, rightEye);
+        // dt глазам не нужен, но задает темп повтора и границу кадра в записи
+        advanceInputFrame(input, clock);
+        // при повторе темп задает запись
+        if (!isReplaying(input)) {
+            waitNextFrame(framePacer);
+        }
     }
+    printPacingReport(framePacer);
+    printReplayReport(input);
+    printLayerReport(eyeBases);
 }
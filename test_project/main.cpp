@@ -64,6 +64,10 @@ namespace std {
 }
 #include <SFML/Graphics.hpp>
 
+#include "../common/baked_scene.h"
+#include "../common/frame_pacer.h"
+#include "../common/profiler.h"
+
 sf::RectangleShape createRectangle(
     const sf::Vector2f& size,
     const sf::Vector2f& position,
@@ -114,62 +118,85 @@ sf::ConvexShape createRoof(
     return trapeze;
 }
 
-int main() {
+void addHouse(
+    BakedScene &scene
+) {
+    // wall
+    addShape(scene, createRectangle(
+        sf::Vector2f(500, 250),
+        sf::Vector2f(300, 400),
+        sf::Color(77, 47, 10)
+    ));
+    // door
+    addShape(scene, createRectangle(
+        sf::Vector2f(70, 140),
+        sf::Vector2f(340, 510),
+        sf::Color::Black
+    ));
+    // pipe
+    addShape(scene, createRectangle(
+        sf::Vector2f(30, 80),
+        sf::Vector2f(600, 280),
+        sf::Color(60, 56, 56)
+    ));
+    addShape(scene, createRectangle(
+        sf::Vector2f(50, 40),
+        sf::Vector2f(590, 240),
+        sf::Color(60, 56, 56)
+    ));
+    // roof
+    addShape(scene, createRoof(
+        200.f,
+        600.f,
+        100.f,
+        sf::Vector2f(550, 300),
+        sf::Color(93, 30, 22)
+    ));
+    // smoke
+    addShape(scene, createCircle(20.f, sf::Color(191, 191, 191), sf::Vector2f(610, 200)));
+    addShape(scene, createCircle(25.f, sf::Color(191, 191, 191), sf::Vector2f(620, 180)));
+    addShape(scene, createCircle(30.f, sf::Color(191, 191, 191), sf::Vector2f(640, 160)));
+    addShape(scene, createCircle(35.f, sf::Color(191, 191, 191), sf::Vector2f(650, 140)));
+    // window
+    addShape(scene, createRectangle(
+        sf::Vector2f(80, 80),
+        sf::Vector2f(550, 520),
+        sf::Color(42, 122, 226)
+    ));
+}
+
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("test_project");
+
     sf::RenderWindow window(sf::VideoMode(1000, 800), "House");
 
+    BakedScene house;
+    addHouse(house);
+    bakeScene(house);
+
+    FramePacer framePacer;
+    initFramePacer(framePacer, std::vector<std::string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
+        PROFILE_ZONE("frame");
+        {
+            PROFILE_ZONE("pollEvents");
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                }
             }
         }
 
         window.clear();
-        // wall
-        window.draw(createRectangle(
-            sf::Vector2f(500, 250),
-            sf::Vector2f(300, 400),
-            sf::Color(77, 47, 10)
-        ));
-        // door
-        window.draw(createRectangle(
-            sf::Vector2f(70, 140),
-            sf::Vector2f(340, 510),
-            sf::Color::Black
-        ));
-        // pipe
-        window.draw(createRectangle(
-            sf::Vector2f(30, 80),
-            sf::Vector2f(600, 280),
-            sf::Color(60, 56, 56)
-        ));
-        window.draw(createRectangle(
-            sf::Vector2f(50, 40),
-            sf::Vector2f(590, 240),
-            sf::Color(60, 56, 56)
-        ));
-        // roof
-        window.draw(createRoof(
-            200.f,
-            600.f,
-            100.f,
-            sf::Vector2f(550, 300),
-            sf::Color(93, 30, 22)
-        ));
-        // smoke
-        window.draw(createCircle(20.f, sf::Color(191, 191, 191), sf::Vector2f(610, 200)));
-        window.draw(createCircle(25.f, sf::Color(191, 191, 191), sf::Vector2f(620, 180)));
-        window.draw(createCircle(30.f, sf::Color(191, 191, 191), sf::Vector2f(640, 160)));
-        window.draw(createCircle(35.f, sf::Color(191, 191, 191), sf::Vector2f(650, 140)));
-        // window
-        window.draw(createRectangle(
-            sf::Vector2f(80, 80),
-            sf::Vector2f(550, 520),
-            sf::Color(42, 122, 226)
-        ));
-        window.display();
+        drawScene(window, house);
+        {
+            PROFILE_ZONE("display");
+            window.display();
+        }
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../../common/redraw_gate.h"
 
 using namespace std;
 using namespace sf;
@@ -38,9 +44,11 @@ void initArrow(
 }
 
 void pollEvents(
-    RenderWindow &window
+    RenderWindow &window,
+    RedrawGate &redrawGate
 ) {
-    while (const auto event = window.pollEvent()) {
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = pollRedrawEvent(redrawGate, window)) {
         if (event->is<Event::Closed>()) {
             window.close();
         }
@@ -51,12 +59,21 @@ void redraw(
     RenderWindow &window,
     const ConvexShape &arrow
 ) {
+    PROFILE_ZONE("render");
     window.clear(Color::White);
     window.draw(arrow);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("workshop_1_1");
+
+    RedrawGate redrawGate;
+    initRedrawGate(redrawGate, vector<string>(argv + 1, argv + argc));
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -71,10 +88,20 @@ int main() {
     ConvexShape arrow;
     initArrow(arrow);
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
-        pollEvents(window);
+        PROFILE_ZONE("frame");
+        pollEvents(window, redrawGate);
+        if (!shouldRedraw(redrawGate, framePacer)) {
+            continue;
+        }
         redraw(window, arrow);
+        finishRedraw(redrawGate);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
+    printRedrawReport(redrawGate, framePacer);
 
     return 0;
 }
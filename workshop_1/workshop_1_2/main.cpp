@@ -3,6 +3,9 @@
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -64,6 +67,7 @@ void pollEvents(
     RenderWindow &window,
     Vector2f &mousePos
 ) {
+    PROFILE_ZONE("pollEvents");
     while (const auto event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -125,6 +129,7 @@ void updateArrow(
     const Vector2f &target,
     const float dt
 ) {
+    PROFILE_ZONE("update");
     const Vector2f toTarget = target - arrow.getPosition();
     // Целевой угл в радианах [-180, 180]
     const float targetAngle = atan2(toTarget.y, toTarget.x);
@@ -138,12 +143,18 @@ void renderFrame(
     RenderWindow &window,
     const ConvexShape &arrow
 ) {
+    PROFILE_ZONE("render");
     window.clear(Color::White);
     window.draw(arrow);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("workshop_1_2");
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -161,11 +172,16 @@ int main() {
     initArrow(arrow);
 
     Clock clock;
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window, mousePos);
         updateArrow(arrow, mousePos, clock.restart().asSeconds());
         renderFrame(window, arrow);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
     return 0;
 }
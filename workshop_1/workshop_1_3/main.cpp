@@ -1,5 +1,11 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+#include "../../common/redraw_gate.h"
 
 using namespace sf;
 using namespace std;
@@ -18,9 +24,11 @@ void initCat(
 }
 
 void pollEvents(
-    RenderWindow &window
+    RenderWindow &window,
+    RedrawGate &redrawGate
 ) {
-    while (const auto event = window.pollEvent()) {
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = pollRedrawEvent(redrawGate, window)) {
         if (event->is<Event::Closed>()) {
             window.close();
         }
@@ -31,12 +39,18 @@ void render(
     RenderWindow &window,
     const Sprite &cat
 ) {
+    PROFILE_ZONE("render");
     window.clear(Color::White);
     window.draw(cat);
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("workshop_1_3");
+
     const string SPRITE_NAME = "cat.png";
 
     try {
@@ -49,10 +63,23 @@ int main() {
             "Cat Sprite"
         );
 
+        RedrawGate redrawGate;
+        initRedrawGate(redrawGate, vector<string>(argv + 1, argv + argc));
+
+        FramePacer framePacer;
+        initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
         while (window.isOpen()) {
-            pollEvents(window);
+            PROFILE_ZONE("frame");
+            pollEvents(window, redrawGate);
+            if (!shouldRedraw(redrawGate, framePacer)) {
+                continue;
+            }
             render(window, cat);
+            finishRedraw(redrawGate);
+            waitNextFrame(framePacer);
         }
+        printPacingReport(framePacer);
+        printRedrawReport(redrawGate, framePacer);
         
     } catch (const sf::Exception& error) {
         cerr << "SFML Error: " << error.what() << endl;
@@ -3,6 +3,10 @@
 #include <iostream>
 #include <memory>
 
+#include "../../common/input_replay.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -12,6 +16,8 @@ constexpr Vector2f WINDOW_CENTER = {WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f};
 constexpr float SAFE_ZONE_RADIUS = 5.f;
 constexpr float LEFT_DIRECTION = -1.f;
 constexpr float RIGHT_DIRECTION = 1.f;
+constexpr float TICK_RATE = 240.f;
+constexpr int MAX_STEPS_PER_FRAME = 8;
 
 // point - точка относительно начала координат
 bool isPointInSafeZone(
@@ -56,6 +62,32 @@ enum class CatState
     Moving,
 };
 
+// Фиксированный шаг физики: время кадров копится в accumulator
+// и расходуется целыми шагами step
+struct FixedTimestep
+{
+    float step = 1.f / TICK_RATE;
+    int maxStepsPerFrame = MAX_STEPS_PER_FRAME;
+    float accumulator = 0.f;
+
+    // Сколько шагов сделать в этом кадре. Время сверх maxStepsPerFrame
+    // шагов отбрасывается, иначе после долгого кадра физика не догонит время
+    int consume(const float frameTime)
+    {
+        const float maxAccumulated = step * static_cast<float>(maxStepsPerFrame);
+        accumulator = min(accumulator + frameTime, maxAccumulated);
+        const int steps = min(static_cast<int>(accumulator / step), maxStepsPerFrame);
+        accumulator -= static_cast<float>(steps) * step;
+        return steps;
+    }
+
+    // Доля шага, прошедшая после последнего состояния: [0, 1)
+    float getAlpha() const
+    {
+        return min(accumulator / step, 1.f);
+    }
+};
+
 struct Cat
 {
     std::unique_ptr<sf::Sprite> sprite = nullptr;
@@ -63,6 +95,9 @@ struct Cat
     Target target;
     // Обработан поворот?
     bool rotationProcessed = true;
+    // Позиция в физике и до последнего шага; спрайт ставится между ними при отрисовке
+    Vector2f position = WINDOW_CENTER;
+    Vector2f previousPosition = WINDOW_CENTER;
 
     Cat(const sf::Texture& texture)
     {
@@ -75,13 +110,18 @@ struct Cat
 
     Vector2f getPosition() 
     {
-        return sprite ? sprite->getPosition() : sf::Vector2f(0.f, 0.f);
+        return position;
     }
 
     void setPosition(const Vector2f newPosition)
     {
-        if (sprite)
-            sprite->setPosition(newPosition);
+        position = newPosition;
+        previousPosition = newPosition;
+    }
+
+    void savePreviousPosition()
+    {
+        previousPosition = position;
     }
 
     bool inSafeZone(const Vector2f point)
@@ -144,8 +184,7 @@ struct Cat
         // Перемещение — использовать нормализованный вектор
         const float maxDistance = MOVE_SPEED * dt;
         const float moveDistance = min(maxDistance, target.distance);
-        if (sprite)
-            sprite->move(target.normVector * moveDistance);
+        position += target.normVector * moveDistance;
 
         // Уменьшение дистанции
         target.distance -= moveDistance;
@@ -158,10 +197,12 @@ struct Cat
         move(dt);
     }
 
-    void draw(RenderWindow &window)
+    void draw(RenderWindow &window, const float alpha)
     {
-        if (sprite)
-            window.draw(*sprite);
+        if (!sprite) return;
+
+        sprite->setPosition(previousPosition + (position - previousPosition) * alpha);
+        window.draw(*sprite);
     }
 };
 
@@ -202,10 +243,12 @@ struct LaserPointer
 
 void pollEvents(
     RenderWindow &window,
+    InputSession &input,
     LaserPointer &laserPointer,
     Cat &cat)
 {
-    while (const auto event = window.pollEvent())
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = pollInputEvent(input, window))
     {
         if (event->is<Event::Closed>())
         {
@@ -233,24 +276,38 @@ void pollEvents(
 void render(
     RenderWindow &window,
     Cat &cat,
-    LaserPointer &laserPointer)
+    LaserPointer &laserPointer,
+    const float alpha)
 {
+    PROFILE_ZONE("render");
     window.clear(Color::White);
 
-    cat.draw(window);
+    cat.draw(window, alpha);
     if (cat.isMoving())
     {
         laserPointer.draw(window);
     }
 
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 }
 
-int main()
+// --record file / --replay file / --replay-fast file: см. input_replay.h
+int main(int argc, char *argv[])
 {
+    const ProfilerDump profilerDump("workshop_1_4");
+
     const string CAT_FILE_NAME = "cat.png";
     const string LASER_POINTER_FILE_NAME = "red_pointer.png";
 
+    InputSession input;
+    if (!initInputSession(input, vector<string>(argv + 1, argv + argc)))
+    {
+        return EXIT_FAILURE;
+    }
+
     try
     {
         const Texture catTexture(CAT_FILE_NAME);
@@ -264,13 +321,29 @@ int main()
             "Cat moves following the laser pointer");
 
         Clock clock;
+        FixedTimestep timestep;
 
+        FramePacer framePacer;
+        initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
         while (window.isOpen())
         {
-            pollEvents(window, laserPointer, cat);
-            cat.update(clock.restart().asSeconds());
-            render(window, cat, laserPointer);
+            PROFILE_ZONE("frame");
+            pollEvents(window, input, laserPointer, cat);
+            const int steps = timestep.consume(advanceInputFrame(input, clock));
+            for (int step = 0; step < steps; ++step)
+            {
+                cat.savePreviousPosition();
+                cat.update(timestep.step);
+            }
+            render(window, cat, laserPointer, timestep.getAlpha());
+            // при повторе темп задает запись
+            if (!isReplaying(input))
+            {
+                waitNextFrame(framePacer);
+            }
         }
+        printPacingReport(framePacer);
+        printReplayReport(input);
     }
     catch (const sf::Exception &error)
     {
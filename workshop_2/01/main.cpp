@@ -1,5 +1,8 @@
 #include <SFML/Graphics.hpp>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -58,6 +61,7 @@ void initBall(
 };
 
 void pollEvents(RenderWindow &window) {
+    PROFILE_ZONE("pollEvents");
     while (const auto event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -99,6 +103,7 @@ void update(
     vector<Ball> &balls,
     Clock &clock
 ) {
+    PROFILE_ZONE("update");
     const float dt = clock.restart().asSeconds();
     for (Ball &ball: balls) {
         setNewPosition(ball, dt);
@@ -109,14 +114,20 @@ void render(
     RenderWindow &window,
     const vector<Ball> &balls
 ) {
+    PROFILE_ZONE("render");
     window.clear();
     for (const auto &ball: balls) {
         window.draw(ball.base);
     }
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("workshop_2_01");
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -140,9 +151,14 @@ int main() {
         {PURPLE_COLOR, CENTER, {-HUNDRED * 2.f, -HUNDRED * 7.f}},
     };
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window);
         update(balls, clock);
         render(window, balls);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -1,7 +1,12 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <random>
 #include <cmath>
 
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
+
 using namespace sf;
 using namespace std;
 
@@ -100,6 +105,7 @@ void initBall(
 };
 
 void pollEvents(RenderWindow &window) {
+    PROFILE_ZONE("pollEvents");
     while (const auto event = window.pollEvent()) {
         if (event->is<Event::Closed>()) {
             window.close();
@@ -169,19 +175,147 @@ void handleCollision(Ball &ballA, Ball &ballB) {
     ballB.speed += speedAlongNormal * normal;
 }
 
+// Режим поиска пар для столкновений
+enum class BroadPhase {
+    BruteForce, // все пары i < j, эталонный режим
+    UniformGrid // только шары из соседних ячеек сетки
+};
+
+constexpr BroadPhase BROAD_PHASE = BroadPhase::UniformGrid;
+
+// Ячейка не меньше диаметра шара: пересекающиеся шары всегда лежат
+// в одной или соседних ячейках (все шары радиуса не больше BALL_SIZE)
+constexpr float GRID_CELL_SIZE = DIAMETER;
+
+// Равномерная сетка, перестраивается на каждом шаге сортировкой подсчетом.
+// Шары ячейки cell лежат в cellBalls[cellStart[cell] .. cellStart[cell + 1])
+// по возрастанию индекса
+struct CollisionGrid {
+    size_t columns = 0;
+    size_t rows = 0;
+    vector<uint32_t> cellOfBall;
+    vector<uint32_t> cellStart;
+    vector<uint32_t> cellBalls;
+    vector<uint32_t> cellCursor;
+    vector<uint32_t> candidates;
+};
+
+void initGrid(
+    CollisionGrid &grid,
+    const float width = WINDOW_WIDTH,
+    const float height = WINDOW_HEIGHT
+) {
+    grid.columns = max<size_t>(1, static_cast<size_t>(ceil(width / GRID_CELL_SIZE)));
+    grid.rows = max<size_t>(1, static_cast<size_t>(ceil(height / GRID_CELL_SIZE)));
+    grid.cellStart.assign(grid.columns * grid.rows + 1, 0);
+}
+
+size_t toCellCoordinate(
+    const float coordinate,
+    const size_t cellsCount
+) {
+    const float cell = coordinate / GRID_CELL_SIZE;
+    if (!(cell > 0.f)) {
+        return 0;
+    }
+    return min(static_cast<size_t>(cell), cellsCount - 1);
+}
+
+void buildGrid(
+    CollisionGrid &grid,
+    const vector<Ball> &balls
+) {
+    const size_t cellsCount = grid.columns * grid.rows;
+    grid.cellOfBall.resize(balls.size());
+    grid.cellBalls.resize(balls.size());
+    fill(grid.cellStart.begin(), grid.cellStart.end(), 0);
+
+    // подсчет шаров в каждой ячейке (по центру шара)
+    for (size_t i = 0; i < balls.size(); ++i) {
+        const Ball &ball = balls[i];
+        const Vector2f center = ball.base.getPosition() + Vector2f(ball.radius, ball.radius);
+        const size_t column = toCellCoordinate(center.x, grid.columns);
+        const size_t row = toCellCoordinate(center.y, grid.rows);
+        const auto cell = static_cast<uint32_t>(row * grid.columns + column);
+        grid.cellOfBall[i] = cell;
+        ++grid.cellStart[cell + 1];
+    }
+
+    // префиксные суммы: cellStart[cell] - начало ячейки в cellBalls
+    for (size_t cell = 0; cell < cellsCount; ++cell) {
+        grid.cellStart[cell + 1] += grid.cellStart[cell];
+    }
+
+    // раскладка по возрастанию индексов, так что внутри ячейки порядок сохраняется
+    grid.cellCursor.assign(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (size_t i = 0; i < balls.size(); ++i) {
+        grid.cellBalls[grid.cellCursor[grid.cellOfBall[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+void handleCollisionsBruteForce(
+    vector<Ball> &balls
+) {
+    for (size_t i = 0; i < balls.size(); ++i) {
+        for (size_t j = i + 1; j < balls.size(); ++j) {
+            handleCollision(balls[i], balls[j]);
+        }
+    }
+}
+
+// Пары обходятся в том же порядке, что и при полном переборе (по i, затем по j),
+// поэтому результат совпадает с BruteForce: пропускаются только пары из
+// несоседних ячеек, а они заведомо не пересекаются
+void handleCollisionsWithGrid(
+    vector<Ball> &balls,
+    CollisionGrid &grid
+) {
+    buildGrid(grid, balls);
+
+    for (size_t i = 0; i < balls.size(); ++i) {
+        const size_t column = grid.cellOfBall[i] % grid.columns;
+        const size_t row = grid.cellOfBall[i] / grid.columns;
+        const size_t firstColumn = column > 0 ? column - 1 : 0;
+        const size_t lastColumn = min(column + 1, grid.columns - 1);
+        const size_t firstRow = row > 0 ? row - 1 : 0;
+        const size_t lastRow = min(row + 1, grid.rows - 1);
+
+        // кандидаты j > i из соседних ячеек 3x3
+        grid.candidates.clear();
+        for (size_t r = firstRow; r <= lastRow; ++r) {
+            for (size_t c = firstColumn; c <= lastColumn; ++c) {
+                const size_t cell = r * grid.columns + c;
+                for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) {
+                    if (grid.cellBalls[k] > i) {
+                        grid.candidates.push_back(grid.cellBalls[k]);
+                    }
+                }
+            }
+        }
+
+        sort(grid.candidates.begin(), grid.candidates.end());
+        for (const uint32_t j: grid.candidates) {
+            handleCollision(balls[i], balls[j]);
+        }
+    }
+}
+
 void update(
     vector<Ball> &balls,
-    Clock &clock
+    CollisionGrid &grid,
+    Clock &clock,
+    const BroadPhase broadPhase = BROAD_PHASE
 ) {
+    PROFILE_ZONE("update");
     const float dt = clock.restart().asSeconds();
     for (Ball &ball: balls) {
         setNewPosition(ball, dt);
     }
 
-    for (size_t i = 0; i < balls.size(); ++i) {
-        for (size_t j = i + 1; j < balls.size(); ++j) {
-            handleCollision(balls[i], balls[j]);
-        }
+    if (broadPhase == BroadPhase::BruteForce) {
+        handleCollisionsBruteForce(balls);
+    } else {
+        handleCollisionsWithGrid(balls, grid);
     }
 };
 
@@ -189,14 +323,20 @@ void render(
     RenderWindow &window,
     const vector<Ball> &balls
 ) {
+    PROFILE_ZONE("render");
     window.clear();
     for (const auto &ball: balls) {
         window.draw(ball.base);
     }
-    window.display();
+    {
+        PROFILE_ZONE("display");
+        window.display();
+    }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+    const ProfilerDump profilerDump("workshop_2_03");
+
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -212,6 +352,9 @@ int main() {
     );
     Clock clock;
 
+    CollisionGrid grid;
+    initGrid(grid);
+
     PRNG generator;
     initGenerator(generator);
 
@@ -223,9 +366,14 @@ int main() {
         {PURPLE_COLOR, CENTER, randomSpeed(generator)},
     };
 
+    FramePacer framePacer;
+    initFramePacer(framePacer, vector<string>(argv + 1, argv + argc));
     while (window.isOpen()) {
+        PROFILE_ZONE("frame");
         pollEvents(window);
-        update(balls, clock);
+        update(balls, grid, clock);
         render(window, balls);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -0,0 +1,325 @@
+// Событийная симуляция шаров: вместо шагов dt считаются точные моменты
+// столкновений шар-шар и шар-стена, и время идет от события к событию
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ball_simulation.h"
+
+using namespace std;
+
+// Защита от зацикливания (например, шары зажаты между стеной и соседом):
+// оставшиеся события обработаются в следующем вызове, а время движка
+// остановится на последнем обработанном событии
+constexpr size_t MAX_EVENTS_PER_ADVANCE = 1000000;
+// Очередь чистится от устаревших событий, когда вырастает больше этого размера
+constexpr size_t MIN_QUEUE_REBUILD_SIZE = 1024;
+
+// Способ продвигать симуляцию во времени
+enum class PhysicsEngine {
+    FixedStep, // шаги dt: integrate + поиск пересечений
+    EventDriven // от события к событию, точно при любой скорости
+};
+
+enum class EventType : uint8_t {
+    Balls,
+    VerticalWall, // левая или правая стена, меняется vx
+    HorizontalWall // верхняя или нижняя стена, меняется vy
+};
+
+// Событие устарело, если у его шаров с момента предсказания были другие
+// столкновения (счетчики не совпадают) - такие события просто пропускаются
+struct CollisionEvent {
+    double time = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t countA = 0;
+    uint32_t countB = 0;
+    EventType type = EventType::Balls;
+};
+
+// Позиция шара i известна на момент ballTime[i]: шары двигаются только
+// тогда, когда участвуют в событии, и все вместе в конце advanceEvents
+struct EventEngine {
+    double time = 0;
+    double width = 0;
+    double height = 0;
+    vector<double> x;
+    vector<double> y;
+    vector<double> vx;
+    vector<double> vy;
+    vector<double> radius;
+    vector<double> ballTime;
+    vector<uint32_t> collisionsCount;
+    vector<CollisionEvent> queue; // min-куча по времени
+    size_t rebuildSize = MIN_QUEUE_REBUILD_SIZE;
+    size_t processedEvents = 0;
+};
+
+// Раньше по времени - выше в куче; при равном времени порядок фиксирован
+inline bool isLaterEvent(
+    const CollisionEvent &lhs,
+    const CollisionEvent &rhs
+) {
+    if (lhs.time != rhs.time) {
+        return lhs.time > rhs.time;
+    }
+    if (lhs.type != rhs.type) {
+        return lhs.type > rhs.type;
+    }
+    return lhs.a != rhs.a ? lhs.a > rhs.a : lhs.b > rhs.b;
+}
+
+inline bool isValidEvent(
+    const EventEngine &engine,
+    const CollisionEvent &event
+) {
+    return engine.collisionsCount[event.a] == event.countA &&
+           (event.type != EventType::Balls || engine.collisionsCount[event.b] == event.countB);
+}
+
+inline void pushEvent(
+    EventEngine &engine,
+    const CollisionEvent &event
+) {
+    engine.queue.push_back(event);
+    push_heap(engine.queue.begin(), engine.queue.end(), isLaterEvent);
+}
+
+// Выбросить устаревшие события, если очередь разрослась
+inline void compactQueue(
+    EventEngine &engine
+) {
+    if (engine.queue.size() <= engine.rebuildSize) {
+        return;
+    }
+    const auto stale = remove_if(engine.queue.begin(), engine.queue.end(), [&](const CollisionEvent &event) {
+        return !isValidEvent(engine, event);
+    });
+    engine.queue.erase(stale, engine.queue.end());
+    make_heap(engine.queue.begin(), engine.queue.end(), isLaterEvent);
+    engine.rebuildSize = max(MIN_QUEUE_REBUILD_SIZE, engine.queue.size() * 2);
+}
+
+inline void moveBallTo(
+    EventEngine &engine,
+    const size_t i,
+    const double time
+) {
+    const double elapsed = time - engine.ballTime[i];
+    engine.x[i] += engine.vx[i] * elapsed;
+    engine.y[i] += engine.vy[i] * elapsed;
+    engine.ballTime[i] = time;
+}
+
+// Момент, когда координата position со скоростью speed дойдет до стены
+// [0, limit]; уже вышедший за стену шар сталкивается сразу
+inline double getWallTime(
+    const double position,
+    const double speed,
+    const double limit,
+    const double now
+) {
+    if (speed > 0) {
+        return now + max(0.0, (limit - position) / speed);
+    }
+    if (speed < 0) {
+        return now + max(0.0, -position / speed);
+    }
+    return numeric_limits<double>::infinity();
+}
+
+inline void predictWalls(
+    EventEngine &engine,
+    const uint32_t i
+) {
+    const double now = engine.ballTime[i];
+    const double diameter = 2 * engine.radius[i];
+    const uint32_t count = engine.collisionsCount[i];
+
+    const double timeX = getWallTime(engine.x[i], engine.vx[i], engine.width - diameter, now);
+    if (isfinite(timeX)) {
+        pushEvent(engine, {timeX, i, i, count, count, EventType::VerticalWall});
+    }
+    const double timeY = getWallTime(engine.y[i], engine.vy[i], engine.height - diameter, now);
+    if (isfinite(timeY)) {
+        pushEvent(engine, {timeY, i, i, count, count, EventType::HorizontalWall});
+    }
+}
+
+// Момент касания шаров a и b: |dp + dv * t| = ra + rb. Считается от более
+// позднего из их времен, позиция второго шара экстраполируется
+inline void predictPair(
+    EventEngine &engine,
+    const uint32_t a,
+    const uint32_t b
+) {
+    const double now = max(engine.ballTime[a], engine.ballTime[b]);
+    const double ax = engine.x[a] + engine.vx[a] * (now - engine.ballTime[a]) + engine.radius[a];
+    const double ay = engine.y[a] + engine.vy[a] * (now - engine.ballTime[a]) + engine.radius[a];
+    const double bx = engine.x[b] + engine.vx[b] * (now - engine.ballTime[b]) + engine.radius[b];
+    const double by = engine.y[b] + engine.vy[b] * (now - engine.ballTime[b]) + engine.radius[b];
+
+    const double dx = bx - ax;
+    const double dy = by - ay;
+    const double dvx = engine.vx[b] - engine.vx[a];
+    const double dvy = engine.vy[b] - engine.vy[a];
+    const double dvdp = dvx * dx + dvy * dy;
+    if (dvdp >= 0) {
+        return; // расходятся
+    }
+
+    const double dvdv = dvx * dvx + dvy * dvy;
+    const double dpdp = dx * dx + dy * dy;
+    const double sigma = engine.radius[a] + engine.radius[b];
+    double hitTime = 0;
+    if (dpdp > sigma * sigma) {
+        const double discriminant = dvdp * dvdp - dvdv * (dpdp - sigma * sigma);
+        if (discriminant < 0) {
+            return; // пролетают мимо
+        }
+        hitTime = -(dvdp + sqrt(discriminant)) / dvdv;
+    }
+
+    pushEvent(engine, {
+                  now + hitTime, a, b,
+                  engine.collisionsCount[a], engine.collisionsCount[b],
+                  EventType::Balls
+              });
+}
+
+inline void predictBall(
+    EventEngine &engine,
+    const uint32_t i,
+    const uint32_t except
+) {
+    predictWalls(engine, i);
+    for (uint32_t j = 0; j < engine.x.size(); ++j) {
+        if (j != i && j != except) {
+            predictPair(engine, i, j);
+        }
+    }
+}
+
+// Упругий удар равных масс: обмен компонентами скорости вдоль нормали,
+// как в handleCollision
+inline void resolveBalls(
+    EventEngine &engine,
+    const uint32_t a,
+    const uint32_t b
+) {
+    const double dx = engine.x[b] + engine.radius[b] - engine.x[a] - engine.radius[a];
+    const double dy = engine.y[b] + engine.radius[b] - engine.y[a] - engine.radius[a];
+    const double distance = sqrt(dx * dx + dy * dy);
+    if (distance <= 0) {
+        return;
+    }
+    const double nx = dx / distance;
+    const double ny = dy / distance;
+    const double speedAlongNormal = (engine.vx[a] - engine.vx[b]) * nx + (engine.vy[a] - engine.vy[b]) * ny;
+    if (speedAlongNormal <= 0) {
+        return;
+    }
+    engine.vx[a] -= speedAlongNormal * nx;
+    engine.vy[a] -= speedAlongNormal * ny;
+    engine.vx[b] += speedAlongNormal * nx;
+    engine.vy[b] += speedAlongNormal * ny;
+}
+
+inline void resolveWall(
+    EventEngine &engine,
+    const uint32_t i,
+    const EventType type
+) {
+    const double diameter = 2 * engine.radius[i];
+    if (type == EventType::VerticalWall) {
+        engine.x[i] = clamp(engine.x[i], 0.0, engine.width - diameter);
+        engine.vx[i] = -engine.vx[i];
+    } else {
+        engine.y[i] = clamp(engine.y[i], 0.0, engine.height - diameter);
+        engine.vy[i] = -engine.vy[i];
+    }
+}
+
+// Загрузить шары из мира и предсказать все события. O(n^2) по числу шаров,
+// поэтому движок рассчитан на разреженные сцены
+inline void initEventEngine(
+    EventEngine &engine,
+    const BallWorld &world
+) {
+    const size_t count = world.size();
+    engine.time = 0;
+    engine.width = world.width;
+    engine.height = world.height;
+    engine.x.assign(world.x.begin(), world.x.end());
+    engine.y.assign(world.y.begin(), world.y.end());
+    engine.vx.assign(world.vx.begin(), world.vx.end());
+    engine.vy.assign(world.vy.begin(), world.vy.end());
+    engine.radius.assign(world.radius.begin(), world.radius.end());
+    engine.ballTime.assign(count, 0);
+    engine.collisionsCount.assign(count, 0);
+    engine.queue.clear();
+    engine.rebuildSize = MIN_QUEUE_REBUILD_SIZE;
+    engine.processedEvents = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        predictWalls(engine, i);
+        for (uint32_t j = i + 1; j < count; ++j) {
+            predictPair(engine, i, j);
+        }
+    }
+}
+
+// Обработать все события до engine.time + deltaTime и записать состояние в мир
+inline void advanceEvents(
+    EventEngine &engine,
+    BallWorld &world,
+    const double deltaTime
+) {
+    const double target = engine.time + deltaTime;
+
+    size_t processed = 0;
+    double lastEventTime = engine.time;
+    while (!engine.queue.empty() && engine.queue.front().time <= target && processed < MAX_EVENTS_PER_ADVANCE) {
+        pop_heap(engine.queue.begin(), engine.queue.end(), isLaterEvent);
+        const CollisionEvent event = engine.queue.back();
+        engine.queue.pop_back();
+        if (!isValidEvent(engine, event)) {
+            continue;
+        }
+        ++processed;
+        lastEventTime = event.time;
+
+        moveBallTo(engine, event.a, event.time);
+        if (event.type == EventType::Balls) {
+            moveBallTo(engine, event.b, event.time);
+            resolveBalls(engine, event.a, event.b);
+            ++engine.collisionsCount[event.a];
+            ++engine.collisionsCount[event.b];
+            predictBall(engine, event.a, event.b);
+            predictBall(engine, event.b, event.a);
+        } else {
+            resolveWall(engine, event.a, event.type);
+            ++engine.collisionsCount[event.a];
+            predictBall(engine, event.a, event.a);
+        }
+        compactQueue(engine);
+    }
+    engine.processedEvents += processed;
+
+    // при упоре в лимит в очереди могут остаться события раньше target:
+    // время дальше них не двигается, иначе шары потом пойдут назад
+    const double reached = processed < MAX_EVENTS_PER_ADVANCE ? target : lastEventTime;
+    engine.time = reached;
+    for (size_t i = 0; i < engine.x.size(); ++i) {
+        moveBallTo(engine, i, reached);
+        world.x[i] = static_cast<float>(engine.x[i]);
+        world.y[i] = static_cast<float>(engine.y[i]);
+        world.vx[i] = static_cast<float>(engine.vx[i]);
+        world.vy[i] = static_cast<float>(engine.vy[i]);
+    }
+}
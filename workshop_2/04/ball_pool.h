@@ -0,0 +1,212 @@
+// Пул шаров для появления и удаления во время работы. Физика по-прежнему
+// идет по плотным массивам BallWorld, а снаружи шар держат через дескриптор
+// (слот, поколение): он не портится, когда шары переставляются, и
+// перестает быть живым после удаления, даже если слот уже занят новым шаром
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "ball_simulation.h"
+
+using namespace std;
+
+constexpr uint32_t NO_BALL = numeric_limits<uint32_t>::max();
+// шары по клику и по --spawn-rate живут столько секунд
+constexpr float BALL_LIFETIME = 5.f;
+constexpr float ENDLESS_LIFETIME = numeric_limits<float>::infinity();
+
+struct BallHandle {
+    uint32_t slot = NO_BALL;
+    uint32_t generation = 0;
+};
+
+// Удаление откладывается до compactBalls: до нее индексы шаров в мире
+// не меняются, поэтому удалять можно прямо во время обхода
+struct BallPool {
+    vector<uint32_t> ballOfSlot; // слот -> индекс в BallWorld или NO_BALL
+    vector<uint32_t> generation; // растет при каждом удалении из слота
+    vector<uint32_t> slotOfBall; // индекс в BallWorld -> слот или NO_BALL
+    vector<float> lifetime; // оставшееся время жизни, по индексу в мире
+    vector<uint32_t> freeSlots;
+    vector<uint32_t> despawned; // индексы в мире, ждущие compactBalls
+    uint64_t spawnedCount = 0; // номер шара для счетчикового генератора
+    uint64_t revision = 0; // меняется при каждом изменении состава шаров
+    float spawnDebt = 0;
+};
+
+// Выдать слоты шарам, уже лежащим в мире, и зарезервировать место:
+// пока шаров не больше capacity, появление и удаление не выделяют память
+inline void initBallPool(
+    BallPool &pool,
+    BallWorld &world,
+    const size_t capacity
+) {
+    reserveBalls(world, capacity);
+    pool.ballOfSlot.reserve(capacity);
+    pool.generation.reserve(capacity);
+    pool.slotOfBall.reserve(capacity);
+    pool.lifetime.reserve(capacity);
+    pool.freeSlots.reserve(capacity);
+    pool.despawned.reserve(capacity);
+
+    for (uint32_t i = 0; i < world.size(); ++i) {
+        pool.ballOfSlot.push_back(i);
+        pool.generation.push_back(0);
+        pool.slotOfBall.push_back(i);
+        pool.lifetime.push_back(ENDLESS_LIFETIME);
+    }
+    pool.spawnedCount = world.size();
+}
+
+inline bool isAlive(
+    const BallPool &pool,
+    const BallHandle &handle
+) {
+    return handle.slot < pool.generation.size() &&
+           pool.generation[handle.slot] == handle.generation &&
+           pool.ballOfSlot[handle.slot] != NO_BALL;
+}
+
+// Дескриптор шара с индексом i в мире; у удаленного шара - пустой
+inline BallHandle getHandle(
+    const BallPool &pool,
+    const size_t i
+) {
+    const uint32_t slot = pool.slotOfBall[i];
+    return slot == NO_BALL ? BallHandle{} : BallHandle{slot, pool.generation[slot]};
+}
+
+inline BallHandle spawnBall(
+    BallPool &pool,
+    BallWorld &world,
+    const Color &color,
+    const Vector2f &position,
+    const Vector2f &speed,
+    const float lifetime = ENDLESS_LIFETIME
+) {
+    uint32_t slot;
+    if (!pool.freeSlots.empty()) {
+        slot = pool.freeSlots.back();
+        pool.freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(pool.generation.size());
+        pool.ballOfSlot.push_back(NO_BALL);
+        pool.generation.push_back(0);
+    }
+
+    pool.ballOfSlot[slot] = static_cast<uint32_t>(world.size());
+    pool.slotOfBall.push_back(slot);
+    pool.lifetime.push_back(lifetime);
+    addBall(world, color, position, speed);
+    ++pool.spawnedCount;
+    ++pool.revision;
+    return {slot, pool.generation[slot]};
+}
+
+// Дескриптор сразу перестает быть живым, слот можно занимать снова;
+// сам шар уйдет из мира в compactBalls. false - шар уже удален
+inline bool despawnBall(
+    BallPool &pool,
+    const BallHandle &handle
+) {
+    if (!isAlive(pool, handle)) {
+        return false;
+    }
+    const uint32_t i = pool.ballOfSlot[handle.slot];
+    pool.ballOfSlot[handle.slot] = NO_BALL;
+    pool.slotOfBall[i] = NO_BALL;
+    ++pool.generation[handle.slot];
+    pool.freeSlots.push_back(handle.slot);
+    pool.despawned.push_back(i);
+    return true;
+}
+
+// Убрать удаленные шары из мира. Идем от больших индексов к меньшим:
+// на место удаленного встает последний шар, а он к этому моменту живой
+inline void compactBalls(
+    BallPool &pool,
+    BallWorld &world
+) {
+    if (pool.despawned.empty()) {
+        return;
+    }
+    sort(pool.despawned.begin(), pool.despawned.end(), greater<>());
+    for (const uint32_t i: pool.despawned) {
+        const size_t last = world.size() - 1;
+        const uint32_t movedSlot = pool.slotOfBall[last];
+        removeBallUnordered(world, i);
+        pool.slotOfBall[i] = movedSlot;
+        pool.lifetime[i] = pool.lifetime[last];
+        pool.slotOfBall.pop_back();
+        pool.lifetime.pop_back();
+        if (i != last) {
+            pool.ballOfSlot[movedSlot] = i;
+        }
+    }
+    pool.despawned.clear();
+    ++pool.revision;
+}
+
+inline void updateLifetimes(
+    BallPool &pool,
+    const float dt
+) {
+    for (size_t i = 0; i < pool.lifetime.size(); ++i) {
+        if (pool.lifetime[i] == ENDLESS_LIFETIME) {
+            continue;
+        }
+        pool.lifetime[i] -= dt;
+        if (pool.lifetime[i] <= 0.f) {
+            despawnBall(pool, getHandle(pool, i));
+        }
+    }
+}
+
+// Шар в случайном месте мира со временем жизни BALL_LIFETIME. Числа берутся
+// по номеру появления, поэтому поток шаров повторяется при том же --seed
+inline BallHandle spawnRandomBall(
+    BallPool &pool,
+    BallWorld &world,
+    const CounterRng &rng
+) {
+    const size_t number = pool.spawnedCount;
+    const Vector2f position = {
+        getRandomFloat(rng, getBallCounter(number, BallStream::PositionX), 0.f, world.width - DIAMETER),
+        getRandomFloat(rng, getBallCounter(number, BallStream::PositionY), 0.f, world.height - DIAMETER)
+    };
+    return spawnBall(pool, world, getRandomColor(rng, number), position, randomSpeed(rng, number), BALL_LIFETIME);
+}
+
+// Появление с постоянной частотой rate шаров в секунду
+inline void spawnAtRate(
+    BallPool &pool,
+    BallWorld &world,
+    const CounterRng &rng,
+    const float rate,
+    const float dt
+) {
+    pool.spawnDebt += rate * dt;
+    for (; pool.spawnDebt >= 1.f; pool.spawnDebt -= 1.f) {
+        spawnRandomBall(pool, world, rng);
+    }
+}
+
+// Верхний шар под точкой (рисуется последним) или NO_BALL
+inline uint32_t findBallAt(
+    const BallPool &pool,
+    const BallWorld &world,
+    const Vector2f &point
+) {
+    for (size_t i = world.size(); i-- > 0;) {
+        const float dx = point.x - world.x[i] - world.radius[i];
+        const float dy = point.y - world.y[i] - world.radius[i];
+        if (pool.slotOfBall[i] != NO_BALL && dx * dx + dy * dy <= world.radius[i] * world.radius[i]) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return NO_BALL;
+}
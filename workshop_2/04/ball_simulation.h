@@ -0,0 +1,892 @@
+// Симуляция шаров без окна: общая для 04 и бенчмарка workshop_2/bench
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define BALLS_HAVE_SSE2 1
+#if defined(__GNUC__)
+#define BALLS_HAVE_AVX2 1
+#endif
+#endif
+
+#include "../../common/command_line.h"
+
+using namespace sf;
+using namespace std;
+
+// general
+constexpr unsigned WINDOW_WIDTH = 800;
+constexpr unsigned WINDOW_HEIGHT = 600;
+constexpr float BALL_SIZE = 40;
+constexpr float DIAMETER = 2 * BALL_SIZE;
+constexpr float HUNDRED = 100.f;
+
+// speed
+constexpr float MIN_SPEED = HUNDRED;
+constexpr float MAX_SPEED = HUNDRED * 4.f;
+
+inline const vector<Color> COLOR_PALETTE = {
+    Color::Red,
+    Color::Green,
+    Color::Blue,
+    Color::Yellow,
+    Color::Magenta,
+    Color::Cyan,
+    Color::White,
+    Color::Black,
+};
+
+// Состояние всех шаров в непрерывных массивах (SoA): физика проходит
+// по памяти подряд и не трогает CircleShape. (x, y) - левый верхний угол,
+// как позиция у CircleShape
+struct BallWorld {
+    float width = WINDOW_WIDTH;
+    float height = WINDOW_HEIGHT;
+    vector<float> x;
+    vector<float> y;
+    vector<float> vx;
+    vector<float> vy;
+    vector<float> radius;
+    vector<Color> color;
+    // позиции до последнего шага физики, для интерполяции при отрисовке
+    vector<float> previousX;
+    vector<float> previousY;
+
+    size_t size() const {
+        return x.size();
+    }
+};
+
+inline void reserveBalls(
+    BallWorld &world,
+    const size_t count
+) {
+    world.x.reserve(count);
+    world.y.reserve(count);
+    world.vx.reserve(count);
+    world.vy.reserve(count);
+    world.radius.reserve(count);
+    world.color.reserve(count);
+    world.previousX.reserve(count);
+    world.previousY.reserve(count);
+}
+
+inline void addBall(
+    BallWorld &world,
+    const Color &color,
+    const Vector2f &position,
+    const Vector2f &speed,
+    const float radius = BALL_SIZE
+) {
+    world.x.push_back(position.x);
+    world.y.push_back(position.y);
+    world.vx.push_back(speed.x);
+    world.vy.push_back(speed.y);
+    world.radius.push_back(radius);
+    world.color.push_back(color);
+    world.previousX.push_back(position.x);
+    world.previousY.push_back(position.y);
+}
+
+// Удалить шар i, переставив на его место последний: O(1), массивы
+// остаются плотными, емкость не меняется. Индекс последнего шара становится i
+inline void removeBallUnordered(
+    BallWorld &world,
+    const size_t i
+) {
+    const size_t last = world.size() - 1;
+    world.x[i] = world.x[last];
+    world.y[i] = world.y[last];
+    world.vx[i] = world.vx[last];
+    world.vy[i] = world.vy[last];
+    world.radius[i] = world.radius[last];
+    world.color[i] = world.color[last];
+    world.previousX[i] = world.previousX[last];
+    world.previousY[i] = world.previousY[last];
+
+    world.x.pop_back();
+    world.y.pop_back();
+    world.vx.pop_back();
+    world.vy.pop_back();
+    world.radius.pop_back();
+    world.color.pop_back();
+    world.previousX.pop_back();
+    world.previousY.pop_back();
+}
+
+inline void savePreviousPositions(
+    BallWorld &world
+) {
+    world.previousX = world.x;
+    world.previousY = world.y;
+}
+
+// Счетчиковый генератор в духе SplitMix64: число с номером counter - это
+// хеш от (seed, counter), состояния между вызовами нет. Поэтому шары можно
+// заполнять в любом порядке и из любого числа потоков с одинаковым итогом
+struct CounterRng {
+    uint64_t seed = 0;
+};
+
+// Независимые потоки чисел одного шара: counter = ball * Count + stream
+enum class BallStream : uint64_t {
+    SpeedX,
+    SpeedY,
+    FirstColor,
+    SecondColor,
+    PositionX,
+    PositionY,
+    Radius,
+    Count
+};
+
+// Сид для запуска без --seed
+inline uint64_t makeRandomSeed() {
+    // Попытка использовать random_device
+    random_device rd;
+    uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    //  time как fallback, если seed мал
+    if (seed == 0) {
+        seed = static_cast<uint64_t>(time(nullptr));
+    }
+    return seed;
+}
+
+// Финализатор SplitMix64 над seed + (counter + 1) * золотое сечение
+inline uint64_t getRandomBits(
+    const CounterRng &rng,
+    const uint64_t counter
+) {
+    uint64_t z = rng.seed + (counter + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t getBallCounter(
+    const size_t ball,
+    const BallStream stream
+) {
+    return static_cast<uint64_t>(ball) * static_cast<uint64_t>(BallStream::Count) + static_cast<uint64_t>(stream);
+}
+
+// Старшие 24 бита -> равномерно в [0, 1) без округления до 1
+inline float toUnitFloat(
+    const uint64_t bits
+) {
+    return static_cast<float>(bits >> 40) * (1.f / 16777216.f);
+}
+
+inline float getRandomFloat(
+    const CounterRng &rng,
+    const uint64_t counter,
+    const float minValue,
+    const float maxValue
+) {
+    return minValue + (maxValue - minValue) * toUnitFloat(getRandomBits(rng, counter));
+}
+
+// Индекс в [0, count) умножением со сдвигом, без деления
+inline size_t getRandomIndex(
+    const CounterRng &rng,
+    const uint64_t counter,
+    const size_t count
+) {
+    return static_cast<size_t>(((getRandomBits(rng, counter) >> 32) * count) >> 32);
+}
+
+// Генерация случайной компоненты скорости в диапазоне [minSpeed, maxSpeed]
+// со случайным знаком: модуль из старших бит, знак из младшего
+inline float randomSpeedComponent(
+    const CounterRng &rng,
+    const uint64_t counter,
+    const float minSpeed = MIN_SPEED,
+    const float maxSpeed = MAX_SPEED
+) {
+    const uint64_t bits = getRandomBits(rng, counter);
+    const float magnitude = minSpeed + (maxSpeed - minSpeed) * toUnitFloat(bits);
+    return bits & 1 ? magnitude : -magnitude;
+}
+
+// возвращаем псевдослучайный вектор скорости шара с номером ball
+inline Vector2f randomSpeed(
+    const CounterRng &rng,
+    const size_t ball,
+    const float minSpeed = MIN_SPEED,
+    const float maxSpeed = MAX_SPEED
+) {
+    return {
+        randomSpeedComponent(rng, getBallCounter(ball, BallStream::SpeedX), minSpeed, maxSpeed),
+        randomSpeedComponent(rng, getBallCounter(ball, BallStream::SpeedY), minSpeed, maxSpeed)
+    };
+}
+
+inline Color getRandomColor(
+    const CounterRng &rng,
+    const size_t ball
+) {
+    // берем цвета по случайным индексам
+    const size_t i = getRandomIndex(rng, getBallCounter(ball, BallStream::FirstColor), COLOR_PALETTE.size());
+    const size_t j = getRandomIndex(rng, getBallCounter(ball, BallStream::SecondColor), COLOR_PALETTE.size());
+    const Color &firstColor = COLOR_PALETTE[i];
+    const Color &secondColor = COLOR_PALETTE[j];
+
+    // среднее арифметическое через лямбду
+    auto avg = [](const uint8_t a, const uint8_t b) -> uint8_t {
+        return static_cast<uint8_t>((a + b) / 2);
+    };
+
+    // rgba
+    return {
+        avg(firstColor.r, secondColor.r),
+        avg(firstColor.g, secondColor.g),
+        avg(firstColor.b, secondColor.b),
+        avg(firstColor.a, secondColor.a)
+    };
+}
+
+// Постоянные рабочие потоки. run() раздает задачи 0..count-1 через атомарный
+// счетчик, вызывающий поток работает наравне с остальными. Какая задача
+// какому потоку достанется, на результат не влияет: задачи одного вызова
+// не должны писать в общие данные
+struct WorkerPool {
+    vector<thread> workers;
+    mutex mtx;
+    condition_variable wake;
+    condition_variable done;
+    const function<void(size_t)> *task = nullptr;
+    size_t tasksCount = 0;
+    atomic<size_t> nextTask{0};
+    size_t busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    // threadsCount - всего потоков вместе с вызывающим
+    explicit WorkerPool(const size_t threadsCount) {
+        for (size_t i = 1; i < threadsCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            lock_guard lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread &worker: workers) {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    size_t size() const {
+        return workers.size() + 1;
+    }
+
+    void run(
+        const size_t count,
+        const function<void(size_t)> &newTask
+    ) {
+        if (workers.empty() || count <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                newTask(i);
+            }
+            return;
+        }
+
+        {
+            lock_guard lock(mtx);
+            task = &newTask;
+            tasksCount = count;
+            nextTask = 0;
+            busyWorkers = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        runTasks();
+
+        unique_lock lock(mtx);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        task = nullptr;
+    }
+
+    void runTasks() {
+        for (size_t i = nextTask.fetch_add(1); i < tasksCount; i = nextTask.fetch_add(1)) {
+            (*task)(i);
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            {
+                unique_lock lock(mtx);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+            runTasks();
+            {
+                lock_guard lock(mtx);
+                if (--busyWorkers == 0) {
+                    done.notify_one();
+                }
+            }
+        }
+    }
+};
+
+// Шаров на одну задачу пула при массовом появлении
+constexpr size_t SPAWN_CHUNK = 16384;
+
+// Добавить count шаров со случайными позициями в пределах мира, скоростями
+// и цветами. Шар i зависит только от rng.seed и своего номера, поэтому
+// массивы заполняются кусками параллельно и итог не зависит от числа потоков
+inline void spawnRandomBalls(
+    BallWorld &world,
+    const size_t count,
+    const CounterRng &rng,
+    WorkerPool &pool,
+    const float radius = BALL_SIZE
+) {
+    const size_t first = world.size();
+    const size_t total = first + count;
+    world.x.resize(total);
+    world.y.resize(total);
+    world.vx.resize(total);
+    world.vy.resize(total);
+    world.radius.resize(total, radius);
+    world.color.resize(total);
+    world.previousX.resize(total);
+    world.previousY.resize(total);
+
+    const float maxX = max(0.f, world.width - 2 * radius);
+    const float maxY = max(0.f, world.height - 2 * radius);
+    const size_t chunksCount = (count + SPAWN_CHUNK - 1) / SPAWN_CHUNK;
+    pool.run(chunksCount, [&](const size_t chunk) {
+        const size_t begin = first + chunk * SPAWN_CHUNK;
+        const size_t end = min(total, begin + SPAWN_CHUNK);
+        for (size_t i = begin; i < end; ++i) {
+            const Vector2f speed = randomSpeed(rng, i);
+            world.x[i] = getRandomFloat(rng, getBallCounter(i, BallStream::PositionX), 0.f, maxX);
+            world.y[i] = getRandomFloat(rng, getBallCounter(i, BallStream::PositionY), 0.f, maxY);
+            world.vx[i] = speed.x;
+            world.vy[i] = speed.y;
+            world.color[i] = getRandomColor(rng, i);
+            world.previousX[i] = world.x[i];
+            world.previousY[i] = world.y[i];
+        }
+    });
+}
+
+inline void setNewPosition(
+    BallWorld &world,
+    const size_t i,
+    const float deltaTime
+) {
+    float newX = world.x[i] + world.vx[i] * deltaTime;
+    float newY = world.y[i] + world.vy[i] * deltaTime;
+
+    const float diameter = 2 * world.radius[i];
+
+    // Отскок по X
+    if (newX < 0) {
+        newX = 0;
+        world.vx[i] = -world.vx[i];
+    } else if (newX + diameter > world.width) {
+        newX = world.width - diameter;
+        world.vx[i] = -world.vx[i];
+    }
+
+    // Отскок по Y
+    if (newY < 0) {
+        newY = 0;
+        world.vy[i] = -world.vy[i];
+    } else if (newY + diameter > world.height) {
+        newY = world.height - diameter;
+        world.vy[i] = -world.vy[i];
+    }
+
+    world.x[i] = newX;
+    world.y[i] = newY;
+}
+
+inline void handleCollision(
+    BallWorld &world,
+    const size_t a,
+    const size_t b
+) {
+    const float radiusA = world.radius[a];
+    const float radiusB = world.radius[b];
+    const Vector2f posA = {world.x[a] + radiusA, world.y[a] + radiusA};
+    const Vector2f posB = {world.x[b] + radiusB, world.y[b] + radiusB};
+    const Vector2f diff = posB - posA;
+    const float distanceSquared = diff.x * diff.x + diff.y * diff.y;
+    const float minDistance = radiusA + radiusB;
+
+    if (distanceSquared >= minDistance * minDistance) {
+        return;
+    }
+
+    // Защита от совпадающих центров
+    if (distanceSquared < 1e-12f) {
+        // ~1e-6 в линейной шкале
+        constexpr float separation = 1e-3f;
+        world.x[a] -= separation;
+        world.x[b] += separation;
+        return;
+    }
+
+    const Vector2f normal = diff / sqrt(distanceSquared);
+    const Vector2f relativeSpeed = {world.vx[a] - world.vx[b], world.vy[a] - world.vy[b]}; // относительная скорость
+    const float speedAlongNormal = relativeSpeed.x * normal.x + relativeSpeed.y * normal.y;
+
+    if (speedAlongNormal <= 0) {
+        return;
+    }
+
+    // обмен скоростями при упругом столкновении (массы равны)
+    const Vector2f impulse = speedAlongNormal * normal;
+    world.vx[a] -= impulse.x;
+    world.vy[a] -= impulse.y;
+    world.vx[b] += impulse.x;
+    world.vy[b] += impulse.y;
+}
+
+// Набор инструкций для ядра движения и отскока от стен
+enum class SimdIsa {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+inline const char *toString(const SimdIsa isa) {
+    switch (isa) {
+        case SimdIsa::Sse2:
+            return "sse2";
+        case SimdIsa::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+// Лучший набор, доступный на этом процессоре
+inline SimdIsa detectSimdIsa() {
+#if BALLS_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdIsa::Avx2;
+    }
+#endif
+#if BALLS_HAVE_SSE2
+    return SimdIsa::Sse2;
+#else
+    return SimdIsa::Scalar;
+#endif
+}
+
+inline vector<SimdIsa> getSupportedIsas() {
+    vector<SimdIsa> isas = {SimdIsa::Scalar};
+    const SimdIsa best = detectSimdIsa();
+    if (best == SimdIsa::Sse2 || best == SimdIsa::Avx2) {
+        isas.push_back(SimdIsa::Sse2);
+    }
+    if (best == SimdIsa::Avx2) {
+        isas.push_back(SimdIsa::Avx2);
+    }
+    return isas;
+}
+
+inline void integrateScalar(
+    BallWorld &world,
+    const size_t begin,
+    const size_t end,
+    const float deltaTime
+) {
+    for (size_t i = begin; i < end; ++i) {
+        setNewPosition(world, i, deltaTime);
+    }
+}
+
+// Векторные версии повторяют setNewPosition операция в операцию, поэтому
+// результат совпадает побитно:
+//   x < 0           -> max(0, x) (именно в этом порядке, чтобы -0 и NaN проходили как есть)
+//   x + d > width   -> width - d через маску (только если не сработала левая стена)
+//   отскок          -> xor знакового бита скорости по маске
+#if BALLS_HAVE_SSE2
+inline size_t integrateSse2(
+    BallWorld &world,
+    const size_t count,
+    const float deltaTime
+) {
+    constexpr size_t LANES = 4;
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.f);
+    const __m128 width = _mm_set1_ps(world.width);
+    const __m128 height = _mm_set1_ps(world.height);
+
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        const __m128 radius = _mm_loadu_ps(&world.radius[i]);
+        const __m128 diameter = _mm_add_ps(radius, radius);
+        __m128 vx = _mm_loadu_ps(&world.vx[i]);
+        __m128 vy = _mm_loadu_ps(&world.vy[i]);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&world.x[i]), _mm_mul_ps(vx, dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&world.y[i]), _mm_mul_ps(vy, dt));
+
+        const __m128 leftX = _mm_cmplt_ps(x, zero);
+        const __m128 rightX = _mm_andnot_ps(leftX, _mm_cmpgt_ps(_mm_add_ps(x, diameter), width));
+        x = _mm_max_ps(zero, x);
+        x = _mm_or_ps(_mm_andnot_ps(rightX, x), _mm_and_ps(rightX, _mm_sub_ps(width, diameter)));
+        vx = _mm_xor_ps(vx, _mm_and_ps(_mm_or_ps(leftX, rightX), signBit));
+
+        const __m128 topY = _mm_cmplt_ps(y, zero);
+        const __m128 bottomY = _mm_andnot_ps(topY, _mm_cmpgt_ps(_mm_add_ps(y, diameter), height));
+        y = _mm_max_ps(zero, y);
+        y = _mm_or_ps(_mm_andnot_ps(bottomY, y), _mm_and_ps(bottomY, _mm_sub_ps(height, diameter)));
+        vy = _mm_xor_ps(vy, _mm_and_ps(_mm_or_ps(topY, bottomY), signBit));
+
+        _mm_storeu_ps(&world.x[i], x);
+        _mm_storeu_ps(&world.y[i], y);
+        _mm_storeu_ps(&world.vx[i], vx);
+        _mm_storeu_ps(&world.vy[i], vy);
+    }
+    return i;
+}
+#endif
+
+#if BALLS_HAVE_AVX2
+__attribute__((target("avx2")))
+inline size_t integrateAvx2(
+    BallWorld &world,
+    const size_t count,
+    const float deltaTime
+) {
+    constexpr size_t LANES = 8;
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.f);
+    const __m256 width = _mm256_set1_ps(world.width);
+    const __m256 height = _mm256_set1_ps(world.height);
+
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        const __m256 radius = _mm256_loadu_ps(&world.radius[i]);
+        const __m256 diameter = _mm256_add_ps(radius, radius);
+        __m256 vx = _mm256_loadu_ps(&world.vx[i]);
+        __m256 vy = _mm256_loadu_ps(&world.vy[i]);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(&world.x[i]), _mm256_mul_ps(vx, dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(&world.y[i]), _mm256_mul_ps(vy, dt));
+
+        const __m256 leftX = _mm256_cmp_ps(x, zero, _CMP_LT_OQ);
+        const __m256 rightX = _mm256_andnot_ps(leftX, _mm256_cmp_ps(_mm256_add_ps(x, diameter), width, _CMP_GT_OQ));
+        x = _mm256_max_ps(zero, x);
+        x = _mm256_blendv_ps(x, _mm256_sub_ps(width, diameter), rightX);
+        vx = _mm256_xor_ps(vx, _mm256_and_ps(_mm256_or_ps(leftX, rightX), signBit));
+
+        const __m256 topY = _mm256_cmp_ps(y, zero, _CMP_LT_OQ);
+        const __m256 bottomY = _mm256_andnot_ps(topY, _mm256_cmp_ps(_mm256_add_ps(y, diameter), height, _CMP_GT_OQ));
+        y = _mm256_max_ps(zero, y);
+        y = _mm256_blendv_ps(y, _mm256_sub_ps(height, diameter), bottomY);
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(_mm256_or_ps(topY, bottomY), signBit));
+
+        _mm256_storeu_ps(&world.x[i], x);
+        _mm256_storeu_ps(&world.y[i], y);
+        _mm256_storeu_ps(&world.vx[i], vx);
+        _mm256_storeu_ps(&world.vy[i], vy);
+    }
+    return i;
+}
+#endif
+
+// Движение и отскок от стен для всех шаров; хвост считается скалярно
+inline void integrate(
+    BallWorld &world,
+    const float deltaTime,
+    const SimdIsa isa
+) {
+    const size_t count = world.size();
+    size_t done = 0;
+    switch (isa) {
+#if BALLS_HAVE_AVX2
+        case SimdIsa::Avx2:
+            done = integrateAvx2(world, count, deltaTime);
+            break;
+#endif
+#if BALLS_HAVE_SSE2
+        case SimdIsa::Sse2:
+            done = integrateSse2(world, count, deltaTime);
+            break;
+#endif
+        default:
+            break;
+    }
+    integrateScalar(world, done, count, deltaTime);
+}
+
+// Режим поиска пар для столкновений. Порядок пар у режимов разный, и
+// результаты расходятся; одинаков при любом числе потоков только
+// ParallelGrid, поэтому он рабочий, а остальные - эталонные
+enum class BroadPhase {
+    BruteForce, // все пары i < j, эталонный режим
+    UniformGrid, // только шары из соседних ячеек сетки, однопоточный эталон
+    ParallelGrid // то же, но пары обрабатываются полосами сетки в WorkerPool
+};
+
+constexpr BroadPhase BROAD_PHASE = BroadPhase::ParallelGrid;
+
+inline const char *toString(const BroadPhase broadPhase) {
+    switch (broadPhase) {
+        case BroadPhase::BruteForce:
+            return "brute_force";
+        case BroadPhase::UniformGrid:
+            return "uniform_grid";
+        default:
+            return "parallel_grid";
+    }
+}
+
+struct SimulationSettings {
+    BroadPhase broadPhase = BROAD_PHASE;
+    SimdIsa isa = SimdIsa::Scalar;
+};
+
+// Ячейка не меньше диаметра шара: пересекающиеся шары всегда лежат
+// в одной или соседних ячейках (все шары радиуса не больше BALL_SIZE)
+constexpr float GRID_CELL_SIZE = DIAMETER;
+
+// Равномерная сетка, перестраивается на каждом шаге сортировкой подсчетом.
+// Шары ячейки cell лежат в cellBalls[cellStart[cell] .. cellStart[cell + 1])
+// по возрастанию индекса
+struct CollisionGrid {
+    size_t columns = 0;
+    size_t rows = 0;
+    vector<uint32_t> cellOfBall;
+    vector<uint32_t> cellStart;
+    vector<uint32_t> cellBalls;
+    vector<uint32_t> cellCursor;
+    vector<uint32_t> candidates;
+    vector<vector<uint64_t>> stripPairs; // пары каждой полосы для ParallelGrid
+};
+
+inline void initGrid(
+    CollisionGrid &grid,
+    const float width,
+    const float height
+) {
+    grid.columns = max<size_t>(1, static_cast<size_t>(ceil(width / GRID_CELL_SIZE)));
+    grid.rows = max<size_t>(1, static_cast<size_t>(ceil(height / GRID_CELL_SIZE)));
+    grid.cellStart.assign(grid.columns * grid.rows + 1, 0);
+}
+
+inline size_t toCellCoordinate(
+    const float coordinate,
+    const size_t cellsCount
+) {
+    const float cell = coordinate / GRID_CELL_SIZE;
+    if (!(cell > 0.f)) {
+        return 0;
+    }
+    return min(static_cast<size_t>(cell), cellsCount - 1);
+}
+
+inline void buildGrid(
+    CollisionGrid &grid,
+    const BallWorld &world
+) {
+    const size_t cellsCount = grid.columns * grid.rows;
+    grid.cellOfBall.resize(world.size());
+    grid.cellBalls.resize(world.size());
+    fill(grid.cellStart.begin(), grid.cellStart.end(), 0);
+
+    // подсчет шаров в каждой ячейке (по центру шара)
+    for (size_t i = 0; i < world.size(); ++i) {
+        const size_t column = toCellCoordinate(world.x[i] + world.radius[i], grid.columns);
+        const size_t row = toCellCoordinate(world.y[i] + world.radius[i], grid.rows);
+        const auto cell = static_cast<uint32_t>(row * grid.columns + column);
+        grid.cellOfBall[i] = cell;
+        ++grid.cellStart[cell + 1];
+    }
+
+    // префиксные суммы: cellStart[cell] - начало ячейки в cellBalls
+    for (size_t cell = 0; cell < cellsCount; ++cell) {
+        grid.cellStart[cell + 1] += grid.cellStart[cell];
+    }
+
+    // раскладка по возрастанию индексов, так что внутри ячейки порядок сохраняется
+    grid.cellCursor.assign(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (size_t i = 0; i < world.size(); ++i) {
+        grid.cellBalls[grid.cellCursor[grid.cellOfBall[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+inline void handleCollisionsBruteForce(
+    BallWorld &world
+) {
+    for (size_t i = 0; i < world.size(); ++i) {
+        for (size_t j = i + 1; j < world.size(); ++j) {
+            handleCollision(world, i, j);
+        }
+    }
+}
+
+// Пары обходятся в том же порядке, что и при полном переборе (по i, затем по j),
+// поэтому результат совпадает с BruteForce: пропускаются только пары из
+// несоседних ячеек, а они заведомо не пересекаются
+inline void handleCollisionsWithGrid(
+    BallWorld &world,
+    CollisionGrid &grid
+) {
+    buildGrid(grid, world);
+
+    for (size_t i = 0; i < world.size(); ++i) {
+        const size_t column = grid.cellOfBall[i] % grid.columns;
+        const size_t row = grid.cellOfBall[i] / grid.columns;
+        const size_t firstColumn = column > 0 ? column - 1 : 0;
+        const size_t lastColumn = min(column + 1, grid.columns - 1);
+        const size_t firstRow = row > 0 ? row - 1 : 0;
+        const size_t lastRow = min(row + 1, grid.rows - 1);
+
+        // кандидаты j > i из соседних ячеек 3x3
+        grid.candidates.clear();
+        for (size_t r = firstRow; r <= lastRow; ++r) {
+            for (size_t c = firstColumn; c <= lastColumn; ++c) {
+                const size_t cell = r * grid.columns + c;
+                for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) {
+                    if (grid.cellBalls[k] > i) {
+                        grid.candidates.push_back(grid.cellBalls[k]);
+                    }
+                }
+            }
+        }
+
+        sort(grid.candidates.begin(), grid.candidates.end());
+        for (const uint32_t j: grid.candidates) {
+            handleCollision(world, i, j);
+        }
+    }
+}
+
+// Параллельная обработка пар. Сетка режется на вертикальные полосы по
+// STRIP_COLUMNS столбцов. Пара принадлежит полосе, в которой лежит ее левый
+// столбец, и трогает шары только этой полосы и следующего за ней столбца.
+// Поэтому четные полосы не пересекаются между собой, нечетные тоже: сначала
+// параллельно обрабатываются все четные, затем все нечетные. Разбиение не
+// зависит от числа потоков, а внутри полосы пары идут по возрастанию (i, j),
+// так что результат побитно одинаков при любом числе потоков
+constexpr size_t STRIP_COLUMNS = 2;
+
+inline uint64_t toPairKey(
+    const uint32_t a,
+    const uint32_t b
+) {
+    return a < b
+               ? (static_cast<uint64_t>(a) << 32) | b
+               : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+inline void collectStripPairs(
+    const CollisionGrid &grid,
+    const size_t strip,
+    vector<uint64_t> &pairs
+) {
+    pairs.clear();
+    const size_t firstColumn = strip * STRIP_COLUMNS;
+    const size_t lastColumn = min(firstColumn + STRIP_COLUMNS, grid.columns);
+
+    for (size_t column = firstColumn; column < lastColumn; ++column) {
+        for (size_t row = 0; row < grid.rows; ++row) {
+            const size_t cell = row * grid.columns + column;
+            const size_t firstRow = row > 0 ? row - 1 : 0;
+            const size_t lastRow = min(row + 1, grid.rows - 1);
+
+            for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) {
+                const uint32_t a = grid.cellBalls[k];
+                for (size_t r = firstRow; r <= lastRow; ++r) {
+                    // свой столбец: пару берем один раз, со стороны меньшего индекса
+                    const size_t sameColumn = r * grid.columns + column;
+                    for (uint32_t m = grid.cellStart[sameColumn]; m < grid.cellStart[sameColumn + 1]; ++m) {
+                        if (grid.cellBalls[m] > a) {
+                            pairs.push_back(toPairKey(a, grid.cellBalls[m]));
+                        }
+                    }
+                    // пары с правым соседним столбцом целиком принадлежат этой полосе
+                    if (column + 1 < grid.columns) {
+                        const size_t nextColumn = sameColumn + 1;
+                        for (uint32_t m = grid.cellStart[nextColumn]; m < grid.cellStart[nextColumn + 1]; ++m) {
+                            pairs.push_back(toPairKey(a, grid.cellBalls[m]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    sort(pairs.begin(), pairs.end());
+}
+
+inline void handleCollisionsInParallel(
+    BallWorld &world,
+    CollisionGrid &grid,
+    WorkerPool &pool
+) {
+    buildGrid(grid, world);
+
+    const size_t stripsCount = (grid.columns + STRIP_COLUMNS - 1) / STRIP_COLUMNS;
+    grid.stripPairs.resize(stripsCount);
+
+    for (size_t parity = 0; parity < 2; ++parity) {
+        const size_t tasksCount = (stripsCount + 1 - parity) / 2;
+        pool.run(tasksCount, [&](const size_t task) {
+            const size_t strip = task * 2 + parity;
+            vector<uint64_t> &pairs = grid.stripPairs[strip];
+            collectStripPairs(grid, strip, pairs);
+            for (const uint64_t key: pairs) {
+                handleCollision(world, key >> 32, key & 0xFFFFFFFFu);
+            }
+        });
+    }
+}
+
+inline void update(
+    BallWorld &world,
+    CollisionGrid &grid,
+    WorkerPool &pool,
+    const SimulationSettings &settings,
+    const float dt
+) {
+    integrate(world, dt, settings.isa);
+
+    switch (settings.broadPhase) {
+        case BroadPhase::BruteForce:
+            handleCollisionsBruteForce(world);
+            break;
+        case BroadPhase::UniformGrid:
+            handleCollisionsWithGrid(world, grid);
+            break;
+        case BroadPhase::ParallelGrid:
+            handleCollisionsInParallel(world, grid, pool);
+            break;
+    }
+};
@@ -1,20 +1,20 @@
 #include <SFML/Graphics.hpp>
-#include <random>
-#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "ball_simulation.h"
+#include "ball_events.h"
+#include "ball_pool.h"
+#include "../../common/triple_buffer.h"
+#include "../../common/frame_pacer.h"
+#include "../../common/profiler.h"
 
 using namespace sf;
 using namespace std;
 
-// general
-constexpr unsigned WINDOW_WIDTH = 800;
-constexpr unsigned WINDOW_HEIGHT = 600;
-constexpr float BALL_SIZE = 40;
-constexpr float DIAMETER = 2 * BALL_SIZE;
-constexpr float HUNDRED = 100.f;
-
-// speed
-constexpr float MIN_SPEED = HUNDRED;
-constexpr float MAX_SPEED = HUNDRED * 4.f;
+// fixed timestep
+constexpr float TICK_RATE = 240.f;
+constexpr int MAX_STEPS_PER_FRAME = 8;
 
 // positions
 constexpr Vector2f TOP_LEFT = {0, 0};
@@ -23,17 +23,6 @@ constexpr Vector2f BOTTOM_LEFT = {0, WINDOW_HEIGHT - DIAMETER};
 constexpr Vector2f BOTTOM_RIGHT = {WINDOW_WIDTH - DIAMETER, WINDOW_HEIGHT - DIAMETER};
 constexpr Vector2f CENTER = {WINDOW_WIDTH / 2.f - BALL_SIZE, WINDOW_HEIGHT / 2.f - BALL_SIZE};
 
-const vector<Color> COLOR_PALETTE = {
-    Color::Red,
-    Color::Green,
-    Color::Blue,
-    Color::Yellow,
-    Color::Magenta,
-    Color::Cyan,
-    Color::White,
-    Color::Black,
-};
-
 const vector<Vector2f> INITIAL_POSITIONS = {
     TOP_LEFT,
     TOP_RIGHT,
@@ -42,185 +31,491 @@ const vector<Vector2f> INITIAL_POSITIONS = {
     CENTER
 };
 
-struct Ball {
-    CircleShape base;
-    Vector2f speed;
-    float radius = BALL_SIZE;
-    Color color;
-
-    Ball(
-        const Color &c,
-        const Vector2f &pos,
-        const Vector2f &spd
-    ) : speed(spd), color(c) {
-        base.setRadius(radius);
-        base.setFillColor(color);
-        base.setPosition(pos);
-    }
+// Сцена из 02 (--scene fast): при дискретном шаге быстрые шары
+// проскакивают друг через друга
+const vector<pair<Vector2f, Vector2f>> FAST_SCENE = {
+    {TOP_LEFT, {HUNDRED * 2.f, HUNDRED * 2.f}},
+    {TOP_RIGHT, {HUNDRED * 3.f, HUNDRED * 3.f}},
+    {BOTTOM_LEFT, {HUNDRED * 4.f, HUNDRED * 4.f}},
+    {BOTTOM_RIGHT, {-HUNDRED * 20.f, HUNDRED * 2.f}},
+    {CENTER, {-HUNDRED * 2.f, -HUNDRED * 7.f}},
 };
 
-struct PRNG {
-    mt19937 engine;
+struct MouseClick {
+    Mouse::Button button = Mouse::Button::Left;
+    Vector2f point;
 };
 
-void initGenerator(PRNG &gen) {
-    // Попытка использовать random_device
-    random_device rd;
-    unsigned seed = rd();
-    //  time как fallback, если seed мал
-    if (seed == 0 || seed == 0x80000000) {
-        seed = static_cast<unsigned>(time(nullptr));
+// Клики не меняют мир сразу: в режиме --pipeline им владеет поток симуляции
+void pollEvents(
+    RenderWindow &window,
+    vector<MouseClick> &clicks
+) {
+    PROFILE_ZONE("pollEvents");
+    while (const auto event = window.pollEvent()) {
+        if (event->is<Event::Closed>()) {
+            window.close();
+        }
+        if (const auto *clicked = event->getIf<Event::MouseButtonPressed>()) {
+            clicks.push_back({clicked->button, Vector2f(clicked->position)});
+        }
     }
-    gen.engine.seed(seed);
 }
 
-// Генерация случайной компоненты скорости в диапазоне [minSpeed, maxSpeed]
-// со случайным знаком
-float randomSpeedComponent(
-    PRNG &gen,
-    const float minSpeed = MIN_SPEED,
-    const float maxSpeed = MAX_SPEED
+// Фиксированный шаг физики: время кадров копится в accumulator
+// и расходуется целыми шагами step
+struct FixedTimestep {
+    float step = 1.f / TICK_RATE;
+    int maxStepsPerFrame = MAX_STEPS_PER_FRAME;
+    float accumulator = 0.f;
+};
+
+// Сколько шагов физики сделать в этом кадре. Время сверх maxStepsPerFrame
+// шагов отбрасывается, иначе после долгого кадра физика не догонит время
+int consumeFrameTime(
+    FixedTimestep &timestep,
+    const float frameTime
 ) {
-    uniform_real_distribution magnitudeDist(minSpeed, maxSpeed);
-    uniform_int_distribution signDist(0, 1);
-    const float magnitude = magnitudeDist(gen.engine);
-    return signDist(gen.engine) ? magnitude : -magnitude;
+    const float maxAccumulated = timestep.step * static_cast<float>(timestep.maxStepsPerFrame);
+    timestep.accumulator = min(timestep.accumulator + frameTime, maxAccumulated);
+    const int steps = min(static_cast<int>(timestep.accumulator / timestep.step), timestep.maxStepsPerFrame);
+    timestep.accumulator -= static_cast<float>(steps) * timestep.step;
+    return steps;
 }
 
-// возвращаем псевдослучайный вектор скорости
-Vector2f randomSpeed(
-    PRNG &gen,
-    const float minSpeed = MIN_SPEED,
-    const float maxSpeed = MAX_SPEED
+// Доля шага, прошедшая после последнего состояния физики: [0, 1)
+float getInterpolationAlpha(
+    const FixedTimestep &timestep
 ) {
-    return {
-        randomSpeedComponent(gen, minSpeed, maxSpeed),
-        randomSpeedComponent(gen, minSpeed, maxSpeed)
-    };
+    return min(timestep.accumulator / timestep.step, 1.f);
 }
 
-Color getRandomColor(PRNG &gen) {
-    // размерность выборки
-    uniform_int_distribution<size_t> indexDist(0, COLOR_PALETTE.size() - 1);
-    // берем цвета по случайным индексам
-    const size_t i = indexDist(gen.engine);
-    const size_t j = indexDist(gen.engine);
-    const Color &firstColor = COLOR_PALETTE[i];
-    const Color &secondColor = COLOR_PALETTE[j];
-
-    // среднее арифметическое через лямбду
-    auto avg = [](const uint8_t a, const uint8_t b) -> uint8_t {
-        return static_cast<uint8_t>((a + b) / 2);
-    };
-
-    // rgba
-    return {
-        avg(firstColor.r, secondColor.r),
-        avg(firstColor.g, secondColor.g),
-        avg(firstColor.b, secondColor.b),
-        avg(firstColor.a, secondColor.a)
-    };
+// Все, чем владеет физика. В режиме --pipeline живет в потоке симуляции
+struct Simulation {
+    BallWorld world;
+    BallPool ballPool;
+    CollisionGrid grid;
+    SimulationSettings settings;
+    PhysicsEngine physicsEngine = PhysicsEngine::FixedStep;
+    EventEngine eventEngine;
+    uint64_t eventEngineRevision = 0;
+    FixedTimestep timestep;
+    CounterRng rng;
+    float spawnRate = 0;
+};
+
+// Левый клик - новый шар в точке клика, правый - удалить шар под курсором
+void handleClick(
+    Simulation &simulation,
+    const MouseClick &click
+) {
+    BallPool &ballPool = simulation.ballPool;
+    if (click.button == Mouse::Button::Left) {
+        const size_t number = ballPool.spawnedCount;
+        spawnBall(
+            ballPool,
+            simulation.world,
+            getRandomColor(simulation.rng, number),
+            click.point - Vector2f(BALL_SIZE, BALL_SIZE),
+            randomSpeed(simulation.rng, number),
+            BALL_LIFETIME
+        );
+    } else if (click.button == Mouse::Button::Right) {
+        const uint32_t i = findBallAt(ballPool, simulation.world, click.point);
+        if (i != NO_BALL) {
+            despawnBall(ballPool, getHandle(ballPool, i));
+        }
+    }
 }
 
-void pollEvents(RenderWindow &window) {
-    while (const auto event = window.pollEvent()) {
-        if (event->is<Event::Closed>()) {
-            window.close();
+// Продвинуть физику на время кадра. Возвращает долю шага для интерполяции
+float advanceSimulation(
+    Simulation &simulation,
+    WorkerPool &pool,
+    const float frameTime
+) {
+    PROFILE_ZONE("update");
+    BallWorld &world = simulation.world;
+    BallPool &ballPool = simulation.ballPool;
+    if (simulation.physicsEngine == PhysicsEngine::EventDriven) {
+        updateLifetimes(ballPool, frameTime);
+        spawnAtRate(ballPool, world, simulation.rng, simulation.spawnRate, frameTime);
+        compactBalls(ballPool, world);
+        // движок держит свои копии шаров: после изменений состава
+        // события предсказываются заново
+        if (ballPool.revision != simulation.eventEngineRevision) {
+            initEventEngine(simulation.eventEngine, world);
+            simulation.eventEngineRevision = ballPool.revision;
         }
+        // события считаются точно на любой длине кадра, интерполяция не нужна
+        advanceEvents(simulation.eventEngine, world, frameTime);
+        savePreviousPositions(world);
+        return 1.f;
     }
+
+    FixedTimestep &timestep = simulation.timestep;
+    const int steps = consumeFrameTime(timestep, frameTime);
+    for (int step = 0; step < steps; ++step) {
+        updateLifetimes(ballPool, timestep.step);
+        spawnAtRate(ballPool, world, simulation.rng, simulation.spawnRate, timestep.step);
+        compactBalls(ballPool, world);
+        // интерполируем между двумя последними состояниями кадра
+        if (step + 1 == steps) {
+            savePreviousPositions(world);
+        }
+        update(world, simulation.grid, pool, simulation.settings, timestep.step);
+    }
+    return getInterpolationAlpha(timestep);
 }
 
-void setNewPosition(Ball &ball, float deltaTime) {
-    auto &shape = ball.base;
-    auto &speed = ball.speed;
+// Число сегментов окружности шара, как у CircleShape по умолчанию
+constexpr size_t CIRCLE_SEGMENTS = 30;
 
-    Vector2f pos = shape.getPosition();
-    Vector2f newPos = pos + speed * deltaTime;
+// Все шары рисуются одним вызовом draw: треугольники каждого шара пишутся
+// в общий VertexArray по заранее посчитанной единичной окружности
+struct BallBatch {
+    vector<Vector2f> unitCircle; // segments + 1 точек, последняя совпадает с первой
+    VertexArray vertices{PrimitiveType::Triangles};
+};
 
-    const float diameter = 2 * ball.radius;
+void initBallBatch(
+    BallBatch &batch,
+    const size_t segmentsCount
+) {
+    const size_t segments = max<size_t>(segmentsCount, 3);
+    batch.unitCircle.resize(segments + 1);
+    for (size_t k = 0; k <= segments; ++k) {
+        // как у CircleShape: первая точка сверху
+        const float angle = static_cast<float>(2 * M_PI * static_cast<double>(k % segments) / static_cast<double>(segments) - M_PI / 2);
+        batch.unitCircle[k] = {cos(angle), sin(angle)};
+    }
+}
 
-    // Отскок по X
-    if (newPos.x < 0) {
-        newPos.x = 0;
-        speed.x = -speed.x;
-    } else if (newPos.x + diameter > WINDOW_WIDTH) {
-        newPos.x = WINDOW_WIDTH - diameter;
-        speed.x = -speed.x;
+// Рисование только читает BallWorld, позиция интерполируется между
+// двумя последними шагами физики
+void render(
+    RenderWindow &window,
+    const BallWorld &world,
+    BallBatch &batch,
+    const float alpha
+) {
+    PROFILE_ZONE("render");
+    const size_t segments = batch.unitCircle.size() - 1;
+    const size_t verticesPerBall = segments * 3;
+    batch.vertices.resize(world.size() * verticesPerBall);
+
+    for (size_t i = 0; i < world.size(); ++i) {
+        const float radius = world.radius[i];
+        const Vector2f center = {
+            world.previousX[i] + (world.x[i] - world.previousX[i]) * alpha + radius,
+            world.previousY[i] + (world.y[i] - world.previousY[i]) * alpha + radius
+        };
+        const Color color = world.color[i];
+
+        Vertex *vertex = &batch.vertices[i * verticesPerBall];
+        for (size_t k = 0; k < segments; ++k) {
+            vertex[0] = {center, color};
+            vertex[1] = {center + batch.unitCircle[k] * radius, color};
+            vertex[2] = {center + batch.unitCircle[k + 1] * radius, color};
+            vertex += 3;
+        }
     }
 
-    // Отскок по Y
-    if (newPos.y < 0) {
-        newPos.y = 0;
-        speed.y = -speed.y;
-    } else if (newPos.y + diameter > WINDOW_HEIGHT) {
-        newPos.y = WINDOW_HEIGHT - diameter;
-        speed.y = -speed.y;
+    window.clear();
+    window.draw(batch.vertices);
+    {
+        PROFILE_ZONE("display");
+        window.display();
     }
+};
+
+// То, что нужно render из мира, плюс доля шага на момент снимка
+struct BallSnapshot {
+    BallWorld world;
+    float alpha = 1.f;
+};
 
-    shape.setPosition(newPos);
+// Копирование в уже выделенные массивы: после первых кадров без выделений
+void takeSnapshot(
+    BallSnapshot &snapshot,
+    const BallWorld &world,
+    const float alpha
+) {
+    snapshot.world.x = world.x;
+    snapshot.world.y = world.y;
+    snapshot.world.previousX = world.previousX;
+    snapshot.world.previousY = world.previousY;
+    snapshot.world.radius = world.radius;
+    snapshot.world.color = world.color;
+    snapshot.alpha = alpha;
 }
 
-void handleCollision(Ball &ballA, Ball &ballB) {
-    const Vector2f posA = ballA.base.getPosition() + Vector2f(ballA.radius, ballA.radius);
-    const Vector2f posB = ballB.base.getPosition() + Vector2f(ballB.radius, ballB.radius);
-    const Vector2f diff = posB - posA;
-    const float distanceSquared = diff.x * diff.x + diff.y * diff.y;
-    const float minDistance = ballA.radius + ballB.radius;
+// --pipeline: физика в своем потоке публикует снимки через тройной буфер,
+// главный поток рисует последний готовый снимок. Время кадра - max из
+// времени физики и отрисовки, а не их сумма
+void runPipelined(
+    RenderWindow &window,
+    Simulation &simulation,
+    WorkerPool &pool,
+    BallBatch &batch,
+    FramePacer &framePacer
+) {
+    TripleBuffer<BallSnapshot> snapshots;
+    mutex clicksMutex;
+    vector<MouseClick> pendingClicks;
+    atomic<bool> running{true};
+
+    thread simulationThread([&] {
+        vector<MouseClick> clicks;
+        Clock clock;
+        while (running.load(memory_order_relaxed)) {
+            {
+                lock_guard lock(clicksMutex);
+                clicks.swap(pendingClicks);
+            }
+            for (const MouseClick &click: clicks) {
+                handleClick(simulation, click);
+            }
+            clicks.clear();
+
+            const float alpha = advanceSimulation(simulation, pool, clock.restart().asSeconds());
+            takeSnapshot(snapshots.getBack(), simulation.world, alpha);
+            snapshots.publish();
+
+            // чаще шага физики снимки не меняются
+            const float untilNextStep = simulation.timestep.step - simulation.timestep.accumulator;
+            if (untilNextStep > 0.f) {
+                sleep(seconds(untilNextStep));
+            }
+        }
+    });
 
-    if (distanceSquared >= minDistance * minDistance) {
-        return;
+    vector<MouseClick> clicks;
+    while (window.isOpen()) {
+        PROFILE_ZONE("frame");
+        pollEvents(window, clicks);
+        if (!clicks.empty()) {
+            lock_guard lock(clicksMutex);
+            pendingClicks.insert(pendingClicks.end(), clicks.begin(), clicks.end());
+            clicks.clear();
+        }
+        snapshots.acquire();
+        const BallSnapshot &snapshot = snapshots.getFront();
+        render(window, snapshot.world, batch, snapshot.alpha);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 
-    // Защита от совпадающих центров
-    if (distanceSquared < 1e-12f) {
-        // ~1e-6 в линейной шкале
-        constexpr Vector2f separation(1e-3f, 0.f);
-        ballA.base.move(-separation);
-        ballB.base.move(separation);
-        return;
+    running = false;
+    simulationThread.join();
+}
+
+// Случайный мир для проверки и замеров: часть шаров стартует за стенами,
+// радиусы разные, среди скоростей есть нули со знаком
+void fillRandomWorld(
+    BallWorld &world,
+    const size_t count,
+    const CounterRng &rng
+) {
+    const float maxPosition = max(world.width, world.height);
+    reserveBalls(world, count);
+    for (size_t i = 0; i < count; ++i) {
+        const float radius = getRandomFloat(rng, getBallCounter(i, BallStream::Radius), 1.f, BALL_SIZE);
+        addBall(
+            world,
+            getRandomColor(rng, i),
+            {
+                getRandomFloat(rng, getBallCounter(i, BallStream::PositionX), -DIAMETER, maxPosition),
+                getRandomFloat(rng, getBallCounter(i, BallStream::PositionY), -DIAMETER, maxPosition)
+            },
+            randomSpeed(rng, i),
+            radius
+        );
+    }
+    for (size_t i = 0; i < min<size_t>(count, 4); ++i) {
+        world.x[i] = -0.f;
+        world.vx[i] = i % 2 ? 0.f : -0.f;
     }
+}
+
+bool isSameFloats(
+    const vector<float> &a,
+    const vector<float> &b
+) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
 
-    const Vector2f normal = diff / sqrt(distanceSquared);
-    const Vector2f relativeSpeed = ballA.speed - ballB.speed; // относительная скорость
-    const float speedAlongNormal = relativeSpeed.x * normal.x + relativeSpeed.y * normal.y;
+bool isSameState(
+    const BallWorld &a,
+    const BallWorld &b
+) {
+    return isSameFloats(a.x, b.x) && isSameFloats(a.y, b.y) &&
+           isSameFloats(a.vx, b.vx) && isSameFloats(a.vy, b.vy);
+}
 
-    if (speedAlongNormal <= 0) {
-        return;
+// Режим проверки: каждое векторное ядро должно совпасть со скалярным побитно
+bool verifyIntegrateKernels() {
+    constexpr unsigned SEED = 2024;
+    constexpr size_t BALLS_COUNT = 1003; // не кратно 4 и 8, чтобы задеть хвост
+    constexpr int STEPS = 1000;
+
+    const CounterRng rng{SEED};
+    BallWorld initial;
+    fillRandomWorld(initial, BALLS_COUNT, rng);
+
+    // шаги берут числа после всех шаров, чтобы не пересекаться с их потоками
+    const uint64_t dtCounter = getBallCounter(BALLS_COUNT, BallStream::SpeedX);
+    bool allSame = true;
+    for (const SimdIsa isa: getSupportedIsas()) {
+        BallWorld scalar = initial;
+        BallWorld vectorized = initial;
+        for (int step = 0; step < STEPS; ++step) {
+            const float dt = getRandomFloat(rng, dtCounter + step, 0.f, 0.05f);
+            integrate(scalar, dt, SimdIsa::Scalar);
+            integrate(vectorized, dt, isa);
+        }
+        const bool same = isSameState(scalar, vectorized);
+        cout << "verify " << toString(isa) << ": " << (same ? "ok" : "MISMATCH") << endl;
+        allSame = allSame && same;
     }
+    return allSame;
+}
+
+// Микробенчмарк ядра: шаров в секунду для каждого доступного набора инструкций
+void benchmarkIntegrateKernels() {
+    constexpr size_t BALLS_COUNT = 1 << 20;
+    constexpr int STEPS = 200;
+    constexpr float DT = 1.f / 240.f;
+
+    BallWorld initial;
+    fillRandomWorld(initial, BALLS_COUNT, CounterRng{1});
 
-    // обмен скоростями при упругом столкновении (массы равны)
-    ballA.speed -= speedAlongNormal * normal;
-    ballB.speed += speedAlongNormal * normal;
+    for (const SimdIsa isa: getSupportedIsas()) {
+        BallWorld world = initial;
+        Clock timer;
+        for (int step = 0; step < STEPS; ++step) {
+            integrate(world, DT, isa);
+        }
+        const float elapsed = timer.getElapsedTime().asSeconds();
+        const double ballsPerSecond = static_cast<double>(BALLS_COUNT) * STEPS / elapsed;
+        cout << toString(isa) << ": " << ballsPerSecond / 1e6 << " M balls/s" << endl;
+    }
 }
 
-void update(
-    vector<Ball> &balls,
-    Clock &clock
+// --broad-phase brute|grid - эталонные однопоточные режимы; без опции
+// параллельная сетка при любом --threads, в том числе при одном потоке
+SimulationSettings getSimulationSettings(
+    const vector<string> &args
 ) {
-    const float dt = clock.restart().asSeconds();
-    for (Ball &ball: balls) {
-        setNewPosition(ball, dt);
+    SimulationSettings settings;
+    settings.isa = detectSimdIsa();
+    const string broadPhase = getStringOption(args, "--broad-phase", "");
+    if (broadPhase == "brute") {
+        settings.broadPhase = BroadPhase::BruteForce;
+    } else if (broadPhase == "grid") {
+        settings.broadPhase = BroadPhase::UniformGrid;
     }
+    return settings;
+}
+
+// Режим проверки: шаг физики с теми же настройками, что у приложения,
+// должен давать побитно одинаковый результат при любом числе потоков
+bool verifyParallelCollisions(
+    const vector<string> &args
+) {
+    constexpr unsigned SEED = 7;
+    constexpr size_t BALLS_COUNT = 2000;
+    constexpr int STEPS = 200;
+    constexpr float DT = 1.f / 240.f;
+    const vector<size_t> THREADS_COUNTS = {1, 2, 3, 4, 8, 16};
+
+    BallWorld initial;
+    initial.width = 3000.f;
+    initial.height = 2000.f;
+    fillRandomWorld(initial, BALLS_COUNT, CounterRng{SEED});
+
+    const SimulationSettings settings = getSimulationSettings(args);
+    cout << "broad phase: " << toString(settings.broadPhase) << endl;
+
+    BallWorld reference;
+    bool allSame = true;
+    for (const size_t threadsCount: THREADS_COUNTS) {
+        BallWorld world = initial;
+        CollisionGrid grid;
+        initGrid(grid, world.width, world.height);
+        WorkerPool pool(threadsCount);
+        for (int step = 0; step < STEPS; ++step) {
+            update(world, grid, pool, settings, DT);
+        }
 
-    for (size_t i = 0; i < balls.size(); ++i) {
-        for (size_t j = i + 1; j < balls.size(); ++j) {
-            handleCollision(balls[i], balls[j]);
+        if (threadsCount == THREADS_COUNTS.front()) {
+            reference = world;
+            continue;
         }
+        const bool same = isSameState(reference, world);
+        cout << "verify " << threadsCount << " threads: " << (same ? "ok" : "MISMATCH") << endl;
+        allSame = allSame && same;
     }
-};
+    return allSame;
+}
 
-void render(
-    RenderWindow &window,
-    const vector<Ball> &balls
-) {
-    window.clear();
-    for (const auto &ball: balls) {
-        window.draw(ball.base);
+// Режим проверки: массовое появление шаров должно давать побитно
+// одинаковый мир при любом числе потоков
+bool verifyParallelSpawn() {
+    constexpr uint64_t SEED = 42;
+    constexpr size_t BALLS_COUNT = 1000003; // не кратно SPAWN_CHUNK
+    const vector<size_t> THREADS_COUNTS = {1, 2, 3, 4, 8, 16};
+    const CounterRng rng{SEED};
+
+    BallWorld reference;
+    bool allSame = true;
+    for (const size_t threadsCount: THREADS_COUNTS) {
+        BallWorld world;
+        world.width = 40000.f;
+        world.height = 40000.f;
+        WorkerPool pool(threadsCount);
+        Clock timer;
+        spawnRandomBalls(world, BALLS_COUNT, rng, pool);
+        const float elapsed = timer.getElapsedTime().asSeconds();
+
+        if (threadsCount == THREADS_COUNTS.front()) {
+            reference = world;
+            cout << "spawn " << threadsCount << " threads: " << elapsed * 1000.f << " ms" << endl;
+            continue;
+        }
+        const bool same = isSameState(reference, world) && reference.color == world.color;
+        cout << "verify " << threadsCount << " threads: " << (same ? "ok" : "MISMATCH")
+                << ", " << elapsed * 1000.f << " ms" << endl;
+        allSame = allSame && same;
     }
-    window.display();
-};
+    return allSame;
+}
+
+int main(int argc, char *argv[]) {
+    const vector<string> args(argv + 1, argv + argc);
+    if (hasFlag(args, "--verify-simd")) {
+        return verifyIntegrateKernels() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (hasFlag(args, "--bench-simd")) {
+        benchmarkIntegrateKernels();
+        return EXIT_SUCCESS;
+    }
+    if (hasFlag(args, "--verify-threads")) {
+        return verifyParallelCollisions(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (hasFlag(args, "--verify-spawn")) {
+        return verifyParallelSpawn() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // --seed N повторяет запуск, в том числе с N = 0; без него сид случайный
+    uint64_t seed = makeRandomSeed();
+    if (!getUnsignedOption(args, "--seed", seed)) {
+        cerr << "--seed expects an unsigned integer" << endl;
+        return EXIT_FAILURE;
+    }
+    const ProfilerDump profilerDump("workshop_2_04");
+
+    const size_t threadsCount = getCountOption(args, "--threads", 1);
 
-int main() {
     ContextSettings settings;
     settings.antiAliasingLevel = 8;
 
@@ -236,23 +531,74 @@ int main() {
     );
     Clock clock;
 
-    PRNG generator;
-    initGenerator(generator);
+    Simulation simulation;
+    simulation.rng = {seed};
+    const CounterRng &rng = simulation.rng;
+    BallWorld &world = simulation.world;
+    WorkerPool pool(threadsCount);
 
-    vector<Ball> balls;
-    balls.reserve(INITIAL_POSITIONS.size());
+    reserveBalls(world, INITIAL_POSITIONS.size());
 
-    for (const auto &pos: INITIAL_POSITIONS) {
-        balls.emplace_back(
-            getRandomColor(generator),
-            pos,
-            randomSpeed(generator)
-        );
+    if (getStringOption(args, "--scene", "") == "fast") {
+        for (const auto &[pos, speed]: FAST_SCENE) {
+            addBall(world, getRandomColor(rng, world.size()), pos, speed);
+        }
+    } else {
+        for (const auto &pos: INITIAL_POSITIONS) {
+            addBall(
+                world,
+                getRandomColor(rng, world.size()),
+                pos,
+                randomSpeed(rng, world.size())
+            );
+        }
+    }
+    // --balls N: еще N шаров в случайных местах, заполняются пулом потоков
+    spawnRandomBalls(world, getCountOption(args, "--balls", 0), rng, pool);
+
+    // --spawn-rate N: N шаров в секунду, каждый живет BALL_LIFETIME секунд.
+    // Запас емкости на установившееся число шаров, дальше без выделений памяти
+    simulation.spawnRate = static_cast<float>(getCountOption(args, "--spawn-rate", 0));
+    initBallPool(
+        simulation.ballPool,
+        world,
+        world.size() + static_cast<size_t>(simulation.spawnRate * BALL_LIFETIME * 2.f)
+    );
+
+    // --engine events: событийный движок вместо фиксированного шага
+    if (getStringOption(args, "--engine", "") == "events") {
+        simulation.physicsEngine = PhysicsEngine::EventDriven;
+        initEventEngine(simulation.eventEngine, world);
+        simulation.eventEngineRevision = simulation.ballPool.revision;
     }
 
+    initGrid(simulation.grid, world.width, world.height);
+
+    simulation.settings = getSimulationSettings(args);
+
+    simulation.timestep.step = 1.f / static_cast<float>(getCountOption(args, "--tick-rate", static_cast<size_t>(TICK_RATE)));
+
+    BallBatch ballBatch;
+    initBallBatch(ballBatch, getCountOption(args, "--segments", CIRCLE_SEGMENTS));
+
+    FramePacer framePacer;
+    initFramePacer(framePacer, args);
+    if (hasFlag(args, "--pipeline")) {
+        runPipelined(window, simulation, pool, ballBatch, framePacer);
+        return EXIT_SUCCESS;
+    }
+
+    vector<MouseClick> clicks;
     while (window.isOpen()) {
-        pollEvents(window);
-        update(balls, clock);
-        render(window, balls);
+        PROFILE_ZONE("frame");
+        pollEvents(window, clicks);
+        for (const MouseClick &click: clicks) {
+            handleClick(simulation, click);
+        }
+        clicks.clear();
+        const float alpha = advanceSimulation(simulation, pool, clock.restart().asSeconds());
+        render(window, world, ballBatch, alpha);
+        waitNextFrame(framePacer);
     }
+    printPacingReport(framePacer);
 }
@@ -0,0 +1,237 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "../04/ball_simulation.h"
+#include "../04/ball_events.h"
+
+using namespace sf;
+using namespace std;
+
+// Бенчмарк физики 04 без окна: setNewPosition/handleCollision для N шаров
+// за M шагов, перебор N от 5 до 1M и числа потоков от 1 до всех ядер.
+//   balls_bench [--balls N] [--max-balls N] [--threads N] [--steps M] [--format csv|json]
+//               [--engine events]
+// Событийный движок однопоточный, строится за O(n^2) и O(n) на событие,
+// поэтому с ним перебор по умолчанию идет до MAX_EVENT_BALLS, а больше
+// шаров не принимается. Все строки перебора потоков считают
+// одну и ту же параллельную сетку; однопоточная сетка UniformGrid для
+// сравнения идет отдельной строкой с mode uniform_grid
+
+// Площадь мира на один шар: плотность одинакова при любом числе шаров
+constexpr float AREA_PER_BALL = 16.f * BALL_SIZE * BALL_SIZE;
+constexpr float BENCH_DT = 1.f / 240.f;
+constexpr size_t DEFAULT_STEPS = 50;
+constexpr size_t WARMUP_STEPS = 5;
+constexpr size_t MIN_BALLS = 5;
+constexpr size_t MAX_BALLS = 1000000;
+constexpr size_t MAX_EVENT_BALLS = 5000;
+constexpr uint64_t BENCH_SEED = 1;
+
+struct BenchResult {
+    string mode;
+    size_t balls = 0;
+    size_t threads = 0;
+    size_t steps = 0;
+    double seconds = 0;
+    long peakRssKb = 0;
+};
+
+// Пиковый RSS процесса с начала работы, в килобайтах
+long getPeakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // на macOS в байтах
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// Мир одинаков при любом числе потоков, поэтому замеры сравнимы
+void spawnBenchBalls(
+    BallWorld &world,
+    const size_t count,
+    WorkerPool &pool
+) {
+    const float side = max(sqrt(AREA_PER_BALL * static_cast<float>(count)), 2 * DIAMETER);
+    world.width = side;
+    world.height = side;
+    spawnRandomBalls(world, count, CounterRng{BENCH_SEED}, pool);
+}
+
+// Тот же замер для событийного движка: шаг - это BENCH_DT симулированного времени
+BenchResult runEventsBench(
+    const size_t ballsCount,
+    const size_t steps
+) {
+    BallWorld world;
+    WorkerPool pool(max(1u, thread::hardware_concurrency()));
+    spawnBenchBalls(world, ballsCount, pool);
+    EventEngine engine;
+    initEventEngine(engine, world);
+
+    for (size_t step = 0; step < WARMUP_STEPS; ++step) {
+        advanceEvents(engine, world, BENCH_DT);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t step = 0; step < steps; ++step) {
+        advanceEvents(engine, world, BENCH_DT);
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    return {"events", ballsCount, 1, steps, elapsed.count(), getPeakRssKb()};
+}
+
+BenchResult runBench(
+    const BroadPhase broadPhase,
+    const size_t ballsCount,
+    const size_t threadsCount,
+    const size_t steps
+) {
+    BallWorld world;
+    WorkerPool pool(threadsCount);
+    spawnBenchBalls(world, ballsCount, pool);
+    CollisionGrid grid;
+    initGrid(grid, world.width, world.height);
+
+    SimulationSettings settings;
+    settings.isa = detectSimdIsa();
+    settings.broadPhase = broadPhase;
+
+    for (size_t step = 0; step < WARMUP_STEPS; ++step) {
+        update(world, grid, pool, settings, BENCH_DT);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t step = 0; step < steps; ++step) {
+        update(world, grid, pool, settings, BENCH_DT);
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    return {toString(broadPhase), ballsCount, threadsCount, steps, elapsed.count(), getPeakRssKb()};
+}
+
+// 5, 50, 500, ... и последним maxBalls
+vector<size_t> getBallsSweep(
+    const size_t maxBalls
+) {
+    vector<size_t> counts;
+    for (size_t count = MIN_BALLS; count < maxBalls; count *= 10) {
+        counts.push_back(count);
+    }
+    counts.push_back(maxBalls);
+    return counts;
+}
+
+// 1, 2, 4, ... и последним все ядра
+vector<size_t> getThreadsSweep() {
+    const size_t cores = max(1u, thread::hardware_concurrency());
+    vector<size_t> counts;
+    for (size_t count = 1; count < cores; count *= 2) {
+        counts.push_back(count);
+    }
+    counts.push_back(cores);
+    return counts;
+}
+
+double getStepsPerSecond(
+    const BenchResult &result
+) {
+    return static_cast<double>(result.steps) / result.seconds;
+}
+
+double getNsPerBall(
+    const BenchResult &result
+) {
+    return result.seconds * 1e9 / static_cast<double>(result.steps * result.balls);
+}
+
+void printCsv(
+    const vector<BenchResult> &results
+) {
+    cout << "mode,balls,threads,steps,steps_per_sec,ns_per_ball,peak_rss_kb" << endl;
+    for (const BenchResult &result: results) {
+        cout << result.mode << ','
+                << result.balls << ','
+                << result.threads << ','
+                << result.steps << ','
+                << getStepsPerSecond(result) << ','
+                << getNsPerBall(result) << ','
+                << result.peakRssKb << endl;
+    }
+}
+
+void printJson(
+    const vector<BenchResult> &results
+) {
+    cout << "[" << endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        cout << "  {\"mode\": \"" << result.mode << "\""
+                << ", \"balls\": " << result.balls
+                << ", \"threads\": " << result.threads
+                << ", \"steps\": " << result.steps
+                << ", \"steps_per_sec\": " << getStepsPerSecond(result)
+                << ", \"ns_per_ball\": " << getNsPerBall(result)
+                << ", \"peak_rss_kb\": " << result.peakRssKb
+                << "}" << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    cout << "]" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    const vector<string> args(argv + 1, argv + argc);
+    const size_t steps = getCountOption(args, "--steps", DEFAULT_STEPS);
+    const string format = getStringOption(args, "--format", "csv");
+    if (format != "csv" && format != "json") {
+        cerr << "unknown format: " << format << endl;
+        return EXIT_FAILURE;
+    }
+
+    const bool isEventDriven = getStringOption(args, "--engine", "") == "events";
+    const size_t singleBalls = getCountOption(args, "--balls", 0);
+    const vector<size_t> ballsSweep = singleBalls > 0
+                                          ? vector<size_t>{singleBalls}
+                                          : getBallsSweep(getCountOption(
+                                              args, "--max-balls", isEventDriven ? MAX_EVENT_BALLS : MAX_BALLS));
+    if (isEventDriven && ballsSweep.back() > MAX_EVENT_BALLS) {
+        cerr << "too many balls for --engine events: " << ballsSweep.back()
+                << ", at most " << MAX_EVENT_BALLS << endl;
+        return EXIT_FAILURE;
+    }
+    const size_t singleThreads = isEventDriven ? 1 : getCountOption(args, "--threads", 0);
+    const vector<size_t> threadsSweep = singleThreads > 0 ? vector<size_t>{singleThreads} : getThreadsSweep();
+
+    // по возрастанию N, чтобы пиковый RSS относился к текущему размеру
+    vector<BenchResult> results;
+    for (const size_t ballsCount: ballsSweep) {
+        if (isEventDriven) {
+            cerr << "balls " << ballsCount << ", events..." << endl;
+            results.push_back(runEventsBench(ballsCount, steps));
+            continue;
+        }
+        cerr << "balls " << ballsCount << ", uniform grid baseline..." << endl;
+        results.push_back(runBench(BroadPhase::UniformGrid, ballsCount, 1, steps));
+        for (const size_t threadsCount: threadsSweep) {
+            cerr << "balls " << ballsCount << ", threads " << threadsCount << "..." << endl;
+            results.push_back(runBench(BroadPhase::ParallelGrid, ballsCount, threadsCount, steps));
+        }
+    }
+
+    if (format == "json") {
+        printJson(results);
+    } else {
+        printCsv(results);
+    }
+    return EXIT_SUCCESS;
+}